@@ -0,0 +1,131 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <wrl.h>
+#include <d3d11.h>
+#include <wincodec.h>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+// =====================================================
+// AssetLoader : file reads and image decodes on worker threads
+//
+// Add(work, done) runs work() on its own thread (std::async) and keeps
+// the future. Poll, called once a frame on the UI thread, hands every
+// finished result to its done() there, so D3D resources that need the
+// immediate context are still created on the thread that owns it.
+// Frames before that simply draw without the texture.
+//
+// The device is free-threaded (created without SINGLETHREADED), so a
+// worker may create resources that only need the device (DDS). WIC
+// images come back as RGBA8 pixels; CreateTexture uploads them and
+// builds the mip chain on the context.
+//
+// Destroying the loader waits for the workers still running.
+// =====================================================
+class AssetLoader
+{
+public:
+    template <typename Work, typename Done>
+    void Add(Work work, Done done)
+    {
+        using Result = std::invoke_result_t<Work>;
+        auto future = std::make_shared<std::future<Result>>(std::async(std::launch::async, std::move(work)));
+        m_Tasks.push_back(
+            [future, done = std::move(done)]() mutable
+            {
+                if (future->wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                    return false;
+                done(future->get());
+                return true;
+            });
+    }
+
+    // 끝난 작업의 done을 부른다. 남은 작업 수
+    size_t Poll()
+    {
+        m_Tasks.erase(std::remove_if(m_Tasks.begin(), m_Tasks.end(),
+            [](std::function<bool()>& task) { return task(); }), m_Tasks.end());
+        return m_Tasks.size();
+    }
+
+    bool Pending() const { return !m_Tasks.empty(); }
+
+private:
+    std::vector<std::function<bool()>> m_Tasks; // true = done을 불렀다
+};
+
+// 디코드된 이미지 : RGBA8, 빈틈없이
+struct DecodedImage
+{
+    UINT width = 0;
+    UINT height = 0;
+    std::vector<uint8_t> pixels; // 비어 있으면 실패
+};
+
+// 워커 스레드에서. WIC는 스레드마다 COM이 필요하다
+inline DecodedImage DecodeImageFile(const wchar_t* file)
+{
+    using Microsoft::WRL::ComPtr;
+
+    DecodedImage img;
+    const HRESULT co = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    {
+        ComPtr<IWICImagingFactory> factory;
+        ComPtr<IWICBitmapDecoder> decoder;
+        ComPtr<IWICBitmapFrameDecode> frame;
+        ComPtr<IWICFormatConverter> converter;
+        if (SUCCEEDED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))) &&
+            SUCCEEDED(factory->CreateDecoderFromFilename(file, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder)) &&
+            SUCCEEDED(decoder->GetFrame(0, &frame)) &&
+            SUCCEEDED(factory->CreateFormatConverter(&converter)) &&
+            SUCCEEDED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA,
+                WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeCustom)) &&
+            SUCCEEDED(converter->GetSize(&img.width, &img.height)))
+        {
+            img.pixels.resize(size_t(img.width) * img.height * 4);
+            if (FAILED(converter->CopyPixels(nullptr, img.width * 4, UINT(img.pixels.size()), img.pixels.data())))
+                img.pixels.clear();
+        }
+    }
+    if (SUCCEEDED(co))
+        CoUninitialize();
+    return img;
+}
+
+// UI 스레드에서 (context). mip은 GPU가 만든다 (CreateWICTextureFromFile과 같다)
+inline HRESULT CreateTexture(ID3D11Device* device, ID3D11DeviceContext* context,
+    const DecodedImage& img, ID3D11ShaderResourceView** srv)
+{
+    if (img.pixels.empty())
+        return E_FAIL;
+
+    D3D11_TEXTURE2D_DESC td{};
+    td.Width = img.width;
+    td.Height = img.height;
+    td.MipLevels = 0; // 전부
+    td.ArraySize = 1;
+    td.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    td.SampleDesc.Count = 1;
+    td.Usage = D3D11_USAGE_DEFAULT;
+    td.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+    td.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+    Microsoft::WRL::ComPtr<ID3D11Texture2D> tex;
+    HRESULT hr = device->CreateTexture2D(&td, nullptr, tex.GetAddressOf());
+    if (SUCCEEDED(hr))
+        hr = device->CreateShaderResourceView(tex.Get(), nullptr, srv);
+    if (FAILED(hr))
+        return hr;
+
+    context->UpdateSubresource(tex.Get(), 0, nullptr, img.pixels.data(), img.width * 4, 0);
+    context->GenerateMips(*srv);
+    return S_OK;
+}
@@ -1,9 +1,23 @@
 #pragma once
 #include <boost/asio.hpp>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <functional>
 #include <memory>
 #include <queue>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "../Shared/BufferSequence.h"
+#include "../Shared/NetLog.h"
+#include "../Shared/Protocol.h"
+#include "../Shared/RecvBuffer.h"
+#include "SpscQueue.h"
 
 using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
 
 struct MoveTarget
 {
@@ -15,32 +29,102 @@ struct MoveTarget
 class AsyncClient : public std::enable_shared_from_this<AsyncClient>
 {
 public:
+    // io thread ٷ ޴  (LoadGen).  尡  SPSC ť  ʴ´
+    using MessageHandler = std::function<void(const Protocol::Message&)>;
+
+    AsyncClient(boost::asio::io_context& io,
+        const std::string& host,
+        uint16_t port,
+        size_t writeBatchLimit = 16 * 1024)
+        : AsyncClient(io, host, port, MessageHandler{}, writeBatchLimit)
+    {
+    }
+
+    // onMessage  PopMessages  io thread ޽ ȣȴ.
+    // io_context  ϳ  Ѵ (ϰ write ť strand )
     AsyncClient(boost::asio::io_context& io,
         const std::string& host,
-        uint16_t port)
+        uint16_t port,
+        MessageHandler onMessage,
+        size_t writeBatchLimit = 16 * 1024)
         : m_IO(io)
         , m_Socket(io)
         , m_Endpoint(boost::asio::ip::make_address(host), port)
+        , m_WriteBatchLimit(writeBatchLimit)
+        , m_ParseRetry(io)
+        , m_OnMessage(std::move(onMessage))
+        , m_Udp(io)
+        , m_UdpTimer(io)
+        , m_ReconnectTimer(io)
+        , m_ReplayTimer(io)
     {
+        if (!m_OnMessage)
+            m_Events = std::make_unique<EventQueue>();
     }
 
     void Start()
     {
+        Connect();
+    }
+
+    // Start  :  ASSIGN UDP Ǿ ָ MOVE UDP (⺻ on)
+    void UseUdp(bool on) { m_UseUdp = on; }
+
+    // Start  :  backoff ΰ ٽ ٴ´ (⺻ on).  v3 RESUME
+    //   ̾޾ ׵ ٲ ͸ ް,  Ǹ ASSIGN + ü 
+    void SetReconnect(bool on) { m_Reconnect = on; }
+
+    // Start  :  TCP Ʈ datagram ״ file  (D3DBoxApp --record)
+    bool Record(const std::filesystem::path& file) { return m_Record.Open(file); }
+
+    // Start  :     ״ Parse / OnDatagram ٽ ִ´.
+    // paced ϵ ð, ƴϸ ̺Ʈ ť ޴ ŭ .   
+    bool Replay(const std::filesystem::path& file, bool paced)
+    {
+        if (!m_ReplayLog.Open(file))
+            return false;
+
+        m_Replaying = true;
+        m_ReplayPaced = paced;
+        m_Reconnect = false;
+        m_UseUdp = false;
         auto self = shared_from_this();
-        m_Socket.async_connect(m_Endpoint,
-            [this, self](boost::system::error_code ec)
+        boost::asio::post(m_IO,
+            [this, self]()
             {
-                if (!ec)
-                    DoRead();
+                m_ReplayStart = std::chrono::steady_clock::now();
+                ReplayStep();
             });
+        return true;
+    }
+
+    // ƹ 忡 : Replay   ־
+    bool ReplayDone() const { return m_ReplayDone.load(std::memory_order_acquire); }
+
+    // ƹ 忡 :   ´ ( ׽Ʈ)
+    void Drop()
+    {
+        auto self = shared_from_this();
+        boost::asio::post(m_IO, [this, self]() { Close(); });
     }
 
+    // ƹ 忡 :  ִ, UDP ְ޴, ݱ ְ Ʈ
+    bool     IsOpen() const { return m_Open.load(std::memory_order_relaxed); }
+    bool     UdpUp() const { return m_UdpUp.load(std::memory_order_relaxed); }
+    uint64_t BytesReceived() const { return m_BytesReceived.load(std::memory_order_relaxed); }
+    uint64_t BytesSent() const { return m_BytesSent.load(std::memory_order_relaxed); }
+    uint64_t Reconnects() const { return m_Reconnects.load(std::memory_order_relaxed); }
+
+    //   ִ    
     void Send(const std::string& msg)
     {
         auto self = shared_from_this();
         boost::asio::post(m_IO,
             [this, self, msg]()
             {
+                if (!m_Ready)
+                    return;
+
                 bool writing = !m_WriteQueue.empty();
                 m_WriteQueue.push_back(msg);
                 if (!writing)
@@ -48,6 +132,35 @@ public:
             });
     }
 
+    // Encoded on the io thread with the version negotiated at ASSIGN.
+    // MOVE goes over UDP once the channel is up.
+    void Send(const Protocol::Message& msg)
+    {
+        auto self = shared_from_this();
+        boost::asio::post(m_IO,
+            [this, self, msg]()
+            {
+                if (!m_Ready)
+                    return;
+
+                if (msg.op == Protocol::Op::Move && m_UdpUp.load(std::memory_order_relaxed))
+                {
+                    SendMoveDatagram(msg);
+                    return;
+                }
+
+                char buf[Protocol::kMaxFrameSize];
+                size_t len = (m_Version >= Protocol::kVersionBinary)
+                    ? Protocol::EncodeBinary(msg, buf)
+                    : Protocol::EncodeText(msg, buf, false);
+
+                bool writing = !m_WriteQueue.empty();
+                m_WriteQueue.emplace_back(buf, len);
+                if (!writing)
+                    DoWrite();
+            });
+    }
+
     bool PopMoveTarget(MoveTarget& out)
     {
         std::lock_guard<std::mutex> lock(m_Mutex);
@@ -59,82 +172,712 @@ public:
         return true;
     }
 
-    bool PopLine(std::string& out)
+    // render thread : ݱ  ̺Ʈ    ( )
+    size_t PopMessages(std::vector<Protocol::Message>& out)
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        if (m_Lines.empty()) return false;
-        out = m_Lines.front();
-        m_Lines.pop();
-        return true;
+        out.clear();
+        if (!m_Events)
+            return 0;
+        return m_Events->PopAll([&out](const Protocol::Message& msg) { out.push_back(msg); });
     }
 
 
 private:
+    // -------------------------
+    // Connect / reconnect (io thread only)
+    // -------------------------
+    static constexpr auto kReconnectMin = std::chrono::milliseconds(250);
+    static constexpr auto kReconnectMax = std::chrono::seconds(8);
+
+    void Connect()
+    {
+        auto self = shared_from_this();
+        m_Socket.async_connect(m_Endpoint,
+            [this, self](boost::system::error_code ec)
+            {
+                if (ec)
+                {
+                    boost::system::error_code ignored;
+                    m_Socket.close(ignored);
+                    ScheduleReconnect();
+                    return;
+                }
+                ++m_Connection;
+                m_Connected = true;
+                m_Open.store(true, std::memory_order_relaxed);
+                if (m_Record.IsOpen())
+                    m_Record.Append(NetLog::Kind::Open, m_Connection);
+                DoRead();
+            });
+    }
+
+    //     (kReconnectMax). ȭ  ó
+    void ScheduleReconnect()
+    {
+        if (!m_Reconnect)
+            return;
+
+        // 25% :  ص Ŭ̾Ʈ    ʰ
+        std::uniform_real_distribution<double> jitter(0.75, 1.25);
+        const auto delay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_Backoff * jitter(m_Rng));
+        m_Backoff = (std::min)(m_Backoff * 2, std::chrono::steady_clock::duration(kReconnectMax));
+
+        auto self = shared_from_this();
+        m_ReconnectTimer.expires_after(delay);
+        m_ReconnectTimer.async_wait(
+            [this, self](boost::system::error_code ec)
+            {
+                if (!ec)
+                    Reconnect();
+            });
+    }
+
+    void Reconnect()
+    {
+        //   async_write  ۸  ִ
+        if (!m_WriteQueue.empty())
+        {
+            ScheduleReconnect();
+            return;
+        }
+
+        m_Recv.Clear();
+        m_Version = Protocol::kVersionText;
+        m_Reconnects.fetch_add(1, std::memory_order_relaxed);
+        Connect();
+    }
+
     void DoRead()
     {
+        if (!m_Connected)
+            return;
+
+        //      ٷ 
+        char* dst = m_Recv.Prepare();
+        if (m_Recv.Space() == 0)
+        {
+            Close();
+            return;
+        }
+
         auto self = shared_from_this();
+        const uint32_t connection = m_Connection;
         m_Socket.async_read_some(
-            boost::asio::buffer(m_ReadBuf),
-            [this, self](boost::system::error_code ec, std::size_t len)
+            boost::asio::buffer(dst, m_Recv.Space()),
+            [this, self, connection, dst](boost::system::error_code ec, std::size_t len)
             {
-                if (!ec)
+                if (connection != m_Connection)
+                    return; // ̹ ٽ پ
+                if (ec)
                 {
-                    Parse(m_ReadBuf.data(), len);
-                    DoRead();
+                    Close();
+                    return;
                 }
+                if (m_Record.IsOpen())
+                    m_Record.Append(NetLog::Kind::Data, m_Connection, dst, len);
+                m_BytesReceived.fetch_add(len, std::memory_order_relaxed);
+                m_Recv.Commit(len);
+                ParseAndRead();
             });
     }
 
+    void ParseAndRead()
+    {
+        if (Parse())
+        {
+            DoRead();
+            return;
+        }
+
+        // ̺Ʈ ť   :  尡    б⸦ 
+        // ( Ʈ m_Recv,  TCP 帧  )
+        auto self = shared_from_this();
+        const uint32_t connection = m_Connection;
+        m_ParseRetry.expires_after(std::chrono::milliseconds(1));
+        m_ParseRetry.async_wait(
+            [this, self, connection](boost::system::error_code ec)
+            {
+                if (!ec && connection == m_Connection && m_Connected)
+                    ParseAndRead();
+            });
+    }
+
+    // ť  û m_WriteBatchLimit  async_write   
     void DoWrite()
     {
+        // replay  
+        if (m_Replaying)
+        {
+            m_WriteQueue.clear();
+            return;
+        }
+
+        m_WriteBatch.clear();
+        size_t bytes = 0;
+        for (auto& msg : m_WriteQueue)
+        {
+            if (!m_WriteBatch.empty() && bytes + msg.size() > m_WriteBatchLimit)
+                break;
+            m_WriteBatch.push_back(boost::asio::buffer(msg));
+            bytes += msg.size();
+        }
+
         auto self = shared_from_this();
         boost::asio::async_write(
             m_Socket,
-            boost::asio::buffer(m_WriteQueue.front()),
-            [this, self](boost::system::error_code ec, std::size_t)
+            BufferSequenceView(m_WriteBatch),
+            [this, self](boost::system::error_code ec, std::size_t sent)
             {
-                if (!ec)
+                if (ec)
                 {
-                    m_WriteQueue.pop_front();
-                    if (!m_WriteQueue.empty())
-                        DoWrite();
+                    //  :  û   ̴ (ٽ   )
+                    m_WriteQueue.clear();
+                    Close();
+                    return;
                 }
+
+                m_BytesSent.fetch_add(sent, std::memory_order_relaxed);
+                m_WriteQueue.erase(m_WriteQueue.begin(), m_WriteQueue.begin() + m_WriteBatch.size());
+                if (!m_WriteQueue.empty())
+                    DoWrite();
             });
 
     }
 
-    void EnqueueLine(const std::string& line)
+    void Close()
     {
-        std::lock_guard<std::mutex> lock(m_Mutex);
-        m_Lines.push(line);
+        if (!m_Connected)
+            return;
+        m_Connected = false;
+        m_Ready = false;
+        m_Resuming = false;
+        if (m_Record.IsOpen())
+            m_Record.Append(NetLog::Kind::Close, m_Connection);
+
+        m_Open.store(false, std::memory_order_relaxed);
+        boost::system::error_code ignored;
+        m_Socket.close(ignored);
+        CloseUdp();
+        ScheduleReconnect();
+    }
+
+    // ڵ鷯  ׻ ڸ ִ
+    size_t FreeEvents()
+    {
+        return m_Events ? m_Events->FreeCount() : Protocol::kMaxFrameMessages;
+    }
+
+    // Parse/ParseFrames FreeEvents  ȮϹǷ push  ʴ´
+    void EnqueueMessage(const Protocol::Message& msg)
+    {
+        // UDP   MOVE ޾Ƶ鿩 (ACK  äη ͵ ȴ)
+        if (msg.op == Protocol::Op::MoveAck && m_UnackedMove.key != 0 &&
+            !Protocol::SeqNewer(uint32_t(m_UnackedMove.key), uint32_t(msg.key)))
+            m_UnackedMove = Protocol::Message{};
+
+        switch (msg.op)
+        {
+        case Protocol::Op::ResumeToken:
+            m_ResumeToken = uint32_t(msg.key);
+            return; //   , ȭ 
+
+        case Protocol::Op::Resume:
+            m_Resuming = false;
+            m_Ready = true;
+            m_Synced = false;
+            if (msg.key != m_SessionKey)
+            {
+                // ޾  ʾҴ (â  ) :  , ü  ´
+                m_SessionKey = msg.key;
+                m_ResumeToken = 0;
+                Forward(Protocol::Message{ Protocol::Op::Assign, msg.key });
+                return;
+            }
+            break;
+
+        case Protocol::Op::Assign:
+            m_SessionKey = msg.key;
+            break;
+
+        case Protocol::Op::SnapshotBegin:
+            m_Synced = false;
+            m_WorldVersion = 0;
+            break;
+
+        case Protocol::Op::SnapshotEnd:
+            m_Synced = true;
+            m_Backoff = kReconnectMin; // پ ȭ ƴ
+            break;
+
+        case Protocol::Op::Tick:
+            if (m_WorldVersion == 0 || Protocol::SeqNewer(uint32_t(msg.key), m_WorldVersion))
+                m_WorldVersion = uint32_t(msg.key);
+            break;
+
+        default:
+            break;
+        }
+
+        Forward(msg);
+    }
+
+    void Forward(const Protocol::Message& msg)
+    {
+        if (m_OnMessage)
+            m_OnMessage(msg);
+        else
+            m_Events->TryPush(msg);
+    }
+
+    // Returns false when the event queue can't take the next line/frame.
+    bool Parse()
+    {
+        std::string_view line;
+        while (m_Version < Protocol::kVersionBinary)
+        {
+            if (FreeEvents() == 0)
+                return false;
+            if (!m_Recv.NextLine(line))
+                break;
+
+            Protocol::Message msg;
+            if (!Protocol::DecodeText(line, msg, true))
+                continue;
+
+            if (msg.op == Protocol::Op::Assign)
+            {
+                Negotiate(line);
+                if (m_Resuming)
+                    continue; //  key    : ̾ key RESUME  ´
+            }
+
+            EnqueueMessage(msg); // SPSC ť push
+        }
+
+        if (m_Version >= Protocol::kVersionBinary)
+            return ParseFrames();
+        return true;
     }
 
-    void Parse(const char* data, size_t len)
+    // ASSIGN <key> [<udpPort> <udpToken>] [maxVersion] :  v2 ϸ HELLO ϰ
+    // ̳ʸ ȯ. v3̰   ū  HELLO  RESUME.
+    // UDP Ƿ  ε Ѵ
+    void Negotiate(std::string_view assignLine)
     {
-        m_Incoming.append(data, len);
+        std::string_view fields[5];
+        size_t count = 0;
+        for (size_t pos = 0; pos < assignLine.size() && count < std::size(fields); )
+        {
+            const size_t sp = (std::min)(assignLine.find(' ', pos), assignLine.size());
+            if (sp > pos)
+                fields[count++] = assignLine.substr(pos, sp - pos);
+            pos = sp + 1;
+        }
+
+        auto parse = [](std::string_view f, auto& v)
+            {
+                std::from_chars(f.data(), f.data() + f.size(), v);
+            };
+
+        int serverVersion = Protocol::kVersionText;
+        if (count >= 3)
+            parse(fields[count - 1], serverVersion);
+
+        int version = (std::min)(serverVersion, Protocol::kVersionLatest);
+        if (version < Protocol::kVersionBinary)
+        {
+            m_Ready = true;
+            return;
+        }
+
+        // HELLO / RESUME ׻ ؽƮ.  Send ̳ʸ ڵȴ.
+        // RESUME  /  RESUME     ƴ´ (0 =  )
+        m_Resuming = (version >= Protocol::kVersionResume && m_ResumeToken != 0);
+        if (!m_Resuming)
+            m_ResumeToken = 0;
 
-        size_t pos = 0;
-        while ((pos = m_Incoming.find('\n')) != std::string::npos)
+        bool writing = !m_WriteQueue.empty();
+        if (m_Resuming)
+        {
+            m_WriteQueue.push_back("RESUME " + std::to_string(m_SessionKey) + " " + std::to_string(m_ResumeToken) +
+                " " + std::to_string(m_Synced ? m_WorldVersion : 0) + "\n");
+        }
+        else
         {
-            std::string line = m_Incoming.substr(0, pos);
-            m_Incoming.erase(0, pos + 1);
+            m_WriteQueue.push_back("HELLO " + std::to_string(version) + "\n");
+        }
+        if (!writing)
+            DoWrite();
+
+        m_Version = version;
+        m_Ready = !m_Resuming; // RESUME      
+
+        if (count == 5 && m_UseUdp)
+        {
+            uint16_t port = 0;
+            parse(fields[2], port);
+            parse(fields[3], m_UdpToken);
+            if (port != 0 && m_UdpToken != 0)
+                StartUdp(port);
+        }
+    }
+
+    // -------------------------
+    // UDP (io thread only)
+    // ū   datagram(probe)    .   up :
+    //  MOVE datagram, flags kUdpFlagReceiving Ǿ  UDP
+    //  Ѵ.    (ȭ ) TCP .
+    // MOVE ACK    ͸ ٽ  (  )
+    // -------------------------
+    static constexpr auto kUdpInterval = std::chrono::milliseconds(100);
+    static constexpr int  kUdpProbes = 20;            // x kUdpInterval
+    static constexpr auto kUdpResend = std::chrono::milliseconds(200);
+    static constexpr int  kUdpMaxResends = 5;
+    static constexpr auto kUdpKeepAlive = std::chrono::seconds(2); // NAT  
+
+    void StartUdp(uint16_t port)
+    {
+        //   :   ε ̴
+        m_UdpProbes = 0;
+        m_UdpReceived = false;
+        m_UnackedMove = Protocol::Message{};
+        m_Resends = 0;
+
+        boost::system::error_code ec;
+        m_Udp.open(udp::v4(), ec);
+        if (!ec)
+            m_Udp.connect(udp::endpoint(m_Endpoint.address(), port), ec);
+        if (!ec)
+            m_Udp.non_blocking(true, ec);
+        if (ec)
+        {
+            CloseUdp();
+            return;
+        }
+
+        DoReadUdp();
+        SendDatagram(nullptr);
+        ScheduleUdp();
+    }
+
+    void CloseUdp()
+    {
+        m_UdpUp.store(false, std::memory_order_relaxed);
+        boost::system::error_code ignored;
+        m_UdpTimer.cancel();
+        m_Udp.close(ignored);
+    }
+
+    // msg == nullptr : probe / keepalive
+    void SendDatagram(const Protocol::Message* msg)
+    {
+        char buf[Protocol::kUdpClientHeader + Protocol::kMaxFrameSize];
+        char* p = Protocol::PutU64(buf, m_UdpToken);
+        p = Protocol::PutU32(p, ++m_UdpSendSeq);
+        *p++ = char(m_UdpUp.load(std::memory_order_relaxed) ? Protocol::kUdpFlagReceiving : 0);
+        if (msg)
+            p += Protocol::EncodeBinary(*msg, p);
 
-            EnqueueLine(line); //   ť push
+        // non-blocking :  ۰  Ҿ Ͱ 
+        boost::system::error_code ec;
+        const size_t sent = m_Udp.send(boost::asio::buffer(buf, size_t(p - buf)), 0, ec);
+        if (!ec)
+            m_BytesSent.fetch_add(sent, std::memory_order_relaxed);
+        m_UdpLastSend = std::chrono::steady_clock::now();
+    }
+
+    void SendMoveDatagram(const Protocol::Message& msg)
+    {
+        SendDatagram(&msg);
+        if (msg.key != 0) // seq  MOVE ACK  ´
+        {
+            m_UnackedMove = msg;
+            m_UnackedSentAt = m_UdpLastSend;
+            m_Resends = 0;
         }
     }
 
+    void ScheduleUdp()
+    {
+        auto self = shared_from_this();
+        m_UdpTimer.expires_after(kUdpInterval);
+        m_UdpTimer.async_wait(
+            [this, self](boost::system::error_code ec)
+            {
+                if (ec || !m_Udp.is_open())
+                    return;
+                OnUdpTimer();
+                if (m_Udp.is_open())
+                    ScheduleUdp();
+            });
+    }
+
+    void OnUdpTimer()
+    {
+        if (!m_UdpUp.load(std::memory_order_relaxed))
+        {
+            if (++m_UdpProbes >= kUdpProbes)
+            {
+                CloseUdp(); //   : TCP
+                return;
+            }
+            SendDatagram(nullptr);
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (m_UnackedMove.key != 0 && now - m_UnackedSentAt >= kUdpResend)
+        {
+            if (m_Resends++ < kUdpMaxResends)
+            {
+                SendDatagram(&m_UnackedMove);
+                m_UnackedSentAt = m_UdpLastSend;
+            }
+            else
+            {
+                m_UnackedMove = Protocol::Message{};
+            }
+        }
+        else if (now - m_UdpLastSend >= kUdpKeepAlive)
+        {
+            SendDatagram(nullptr);
+        }
+    }
+
+    void DoReadUdp()
+    {
+        auto self = shared_from_this();
+        m_Udp.async_receive(boost::asio::buffer(m_UdpRecv),
+            [this, self](boost::system::error_code ec, std::size_t len)
+            {
+                if (ec == boost::asio::error::operation_aborted || !m_Udp.is_open())
+                    return;
+                // connected UDP ICMP port unreachable ⼭ ޴´ :  datagram  
+                if (!ec)
+                    OnDatagram(len);
+                DoReadUdp();
+            });
+    }
+
+    void OnDatagram(size_t len)
+    {
+        if (m_Record.IsOpen())
+            m_Record.Append(NetLog::Kind::Datagram, m_Connection, m_UdpRecv.data(), len);
+        if (len < Protocol::kUdpServerHeader)
+            return;
+
+        // ʰ   / ߺ 
+        const uint32_t seq = Protocol::GetU32(m_UdpRecv.data());
+        if (m_UdpReceived && !Protocol::SeqNewer(seq, m_UdpRecvSeq))
+            return;
+
+        //  尡 з   datagram Ҿ  (TCPó ٷ  ʿ䰡 )
+        if (FreeEvents() < Protocol::kMaxFrameMessages)
+            return;
+
+        m_UdpReceived = true;
+        m_UdpRecvSeq = seq;
+        m_BytesReceived.fetch_add(len, std::memory_order_relaxed);
+
+        if (!m_UdpUp.load(std::memory_order_relaxed))
+        {
+            //  -> Ŭ̾Ʈ ΰ  ִ. Ե ˸
+            m_UdpUp.store(true, std::memory_order_relaxed);
+            SendDatagram(nullptr);
+        }
+
+        Protocol::DecodeDatagram(m_UdpRecv.data() + Protocol::kUdpServerHeader, len - Protocol::kUdpServerHeader,
+            [this](const Protocol::Message& msg) { EnqueueMessage(msg); });
+    }
+
+    bool ParseFrames()
+    {
+        for (;;)
+        {
+            std::string_view data = m_Recv.Data();
+            if (data.empty())
+                break;
+
+            //  (MOVE batch, OBSTACLE_ROWS) Ǯ  ִ ִ ̺Ʈ ŭ  ־ ڵ
+            if (FreeEvents() < Protocol::kMaxFrameMessages)
+                return false;
+
+            int used = Protocol::DecodeFrame(data.data(), data.size(),
+                [this](const Protocol::Message& msg) { EnqueueMessage(msg); });
+            if (used < 0)
+            {
+                Close();
+                break;
+            }
+            if (used == 0)
+                break;
+
+            m_Recv.Consume(used);
+        }
+        return true;
+    }
+
+    // -------------------------
+    // Replay (io thread only)
+    // -------------------------
+    static constexpr int kReplayBatch = 256; // ̸ŭ ְ io thread 纸Ѵ
+
+    void ReplayStep()
+    {
+        for (int n = 0; n < kReplayBatch; ++n)
+        {
+            // ̺Ʈ ť    Ǭ Ʈ  ִ
+            if (m_ReplayBacklog)
+            {
+                if (!Parse())
+                    return ReplayWait(std::chrono::steady_clock::now() + std::chrono::milliseconds(1));
+                m_ReplayBacklog = false;
+            }
+
+            if (!m_ReplayHasNext && !(m_ReplayHasNext = m_ReplayLog.Next(m_ReplayNext)))
+            {
+                Close();
+                m_ReplayDone.store(true, std::memory_order_release);
+                return;
+            }
+
+            const NetLog::Record& r = m_ReplayNext;
+            if (m_ReplayPaced)
+            {
+                const auto due = m_ReplayStart + std::chrono::nanoseconds(r.timeNs);
+                if (due > std::chrono::steady_clock::now())
+                    return ReplayWait(due);
+            }
+
+            switch (r.kind)
+            {
+            case NetLog::Kind::Open:
+                Close();
+                m_Recv.Clear();
+                m_Version = Protocol::kVersionText;
+                ++m_Connection;
+                m_Connected = true;
+                m_Open.store(true, std::memory_order_relaxed);
+                break;
+
+            case NetLog::Kind::Data:
+            {
+                if (!m_Connected)
+                    break;
+                char* dst = m_Recv.Prepare(r.size);
+                if (m_Recv.Space() < r.size)
+                {
+                    Close();
+                    break;
+                }
+                std::memcpy(dst, r.data, r.size);
+                m_Recv.Commit(r.size);
+                m_BytesReceived.fetch_add(r.size, std::memory_order_relaxed);
+                m_ReplayBacklog = !Parse();
+                break;
+            }
+
+            case NetLog::Kind::Datagram:
+                // δ  datagram ٷȴ ִ´ : Ź  
+                if (FreeEvents() < Protocol::kMaxFrameMessages)
+                    return ReplayWait(std::chrono::steady_clock::now() + std::chrono::milliseconds(1));
+                if (r.size <= m_UdpRecv.size())
+                {
+                    std::memcpy(m_UdpRecv.data(), r.data, r.size);
+                    OnDatagram(r.size);
+                }
+                break;
+
+            case NetLog::Kind::Close:
+                Close();
+                break;
+
+            default:
+                break;
+            }
+            m_ReplayHasNext = false;
+        }
+
+        auto self = shared_from_this();
+        boost::asio::post(m_IO, [this, self]() { ReplayStep(); });
+    }
+
+    void ReplayWait(std::chrono::steady_clock::time_point until)
+    {
+        auto self = shared_from_this();
+        m_ReplayTimer.expires_at(until);
+        m_ReplayTimer.async_wait(
+            [this, self](boost::system::error_code ec)
+            {
+                if (!ec)
+                    ReplayStep();
+            });
+    }
+
 
 private:
     boost::asio::io_context& m_IO;
     tcp::socket m_Socket;
     tcp::endpoint m_Endpoint;
 
-    std::array<char, 512> m_ReadBuf{};
+    RecvBuffer m_Recv;
     std::deque<std::string> m_WriteQueue;
+    std::vector<boost::asio::const_buffer> m_WriteBatch; // in-flight
+    size_t m_WriteBatchLimit; // async_write     ִ Ʈ
+
+    int m_Version = Protocol::kVersionText; // io thread only
+    boost::asio::steady_timer m_ParseRetry;
+    using EventQueue = SpscQueue<Protocol::Message, 8192>;
+    std::unique_ptr<EventQueue> m_Events; // io thread -> render thread (ڵ鷯  null)
+    MessageHandler m_OnMessage;
+
+    // UDP (io thread only, m_UdpUp ƹ 忡 д´)
+    bool m_UseUdp = true;
+    udp::socket m_Udp;
+    boost::asio::steady_timer m_UdpTimer; // probe / MOVE  / keepalive
+    std::array<char, 2048> m_UdpRecv;
+    uint64_t m_UdpToken = 0;
+    uint32_t m_UdpSendSeq = 0;
+    uint32_t m_UdpRecvSeq = 0;
+    bool m_UdpReceived = false; // m_UdpRecvSeq ȿ
+    int m_UdpProbes = 0;
+    std::chrono::steady_clock::time_point m_UdpLastSend;
+    Protocol::Message m_UnackedMove;      // key = seq, 0̸ 
+    std::chrono::steady_clock::time_point m_UnackedSentAt;
+    int m_Resends = 0;
+    std::atomic<bool> m_UdpUp{ false };
+
+    //  / RESUME (io thread only)
+    bool m_Reconnect = true;
+    bool m_Connected = false;     //  پ ִ
+    bool m_Ready = false;         // ASSIGN óߴ (RESUME̸   ) : Send 
+    bool m_Resuming = false;      // RESUME   ٸ
+    uint32_t m_Connection = 0;    //   +1 :   б ڵ鷯 
+    boost::asio::steady_timer m_ReconnectTimer;
+    std::chrono::steady_clock::duration m_Backoff = kReconnectMin;
+    std::mt19937 m_Rng{ std::random_device{}() };
+    int m_SessionKey = 0;
+    uint32_t m_ResumeToken = 0;   // 0 = 
+    uint32_t m_WorldVersion = 0;  //  TICK (UDP   )
+    bool m_Synced = false;        //  / RESUME  Դ
+
+    // --record / --replay
+    NetLog::Writer m_Record;
+    NetLog::Reader m_ReplayLog;        // io thread only
+    NetLog::Record m_ReplayNext;       // m_ReplayHasNext    ڵ
+    bool m_ReplayHasNext = false;
+    bool m_ReplayBacklog = false;      // m_Recv Parse  Ʈ Ҵ
+    bool m_Replaying = false;
+    bool m_ReplayPaced = false;
+    std::chrono::steady_clock::time_point m_ReplayStart;
+    boost::asio::steady_timer m_ReplayTimer;
+    std::atomic<bool> m_ReplayDone{ false };
 
-    std::string m_Incoming;
+    std::atomic<bool>     m_Open{ false };
+    std::atomic<uint64_t> m_Reconnects{ 0 };
+    std::atomic<uint64_t> m_BytesReceived{ 0 };
+    std::atomic<uint64_t> m_BytesSent{ 0 };
     std::mutex m_Mutex;
-    std::queue<std::string> m_Lines;
     std::queue<MoveTarget> m_TargetQueue;
 };
 
@@ -1,7 +1,7 @@
 
 cbuffer CBVS : register(b0)
 {
-    matrix gWorld;
+    matrix gWorld;      // unused here : world comes per instance
     matrix gViewProj;
 }
 
@@ -23,6 +23,12 @@ struct VS_IN
     float3 pos : POSITION;
     float2 uv : TEXCOORD;
     float3 nrm : NORMAL;
+
+    // slot 1, per instance : rows of the (row-vector) world matrix
+    float4 world0 : WORLD0;
+    float4 world1 : WORLD1;
+    float4 world2 : WORLD2;
+    float4 world3 : WORLD3;
 };
 
 struct PSInput
@@ -36,10 +42,11 @@ struct PSInput
 PSInput VSMain(VS_IN i)
 {
     PSInput o;
-    float4 posW = mul(float4(i.pos, 1), gWorld);
+    float4x4 world = float4x4(i.world0, i.world1, i.world2, i.world3);
+    float4 posW = mul(float4(i.pos, 1), world);
     o.pos = mul(posW, gViewProj);
     o.posW = posW.xyz;
-    o.nrmW = mul((float3x3) gWorld, i.nrm);
+    o.nrmW = mul((float3x3) world, i.nrm);
     o.uv = i.uv;
     return o;
 }
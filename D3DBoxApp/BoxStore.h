@@ -0,0 +1,225 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <DirectXMath.h>
+#include <SimpleMath.h>
+#include "Interpolation.h"
+
+// =====================================================
+// BoxStore : player boxes as structure-of-arrays
+//
+// Boxes only slide on the ground (y = 0) in straight lines between cell
+// centers. The hot data (position, target, speed) is kept in separate
+// float arrays padded to a multiple of 4, so Update moves four boxes per
+// XMVECTOR. Paths and interpolation buffers are cold and stored apart.
+//
+// key -> index is a sparse map. Remove swaps the last box into the hole,
+// so an index is only valid until the next Spawn / Remove / Clear.
+// No world matrix is stored: the renderer builds it when it writes the
+// instance buffer.
+// =====================================================
+class BoxStore
+{
+public:
+    using Vector3 = DirectX::SimpleMath::Vector3;
+
+    static constexpr float kDefaultSpeed = 5.0f; // cells/sec
+
+    size_t Size() const { return m_Keys.size(); }
+    int    Key(size_t i) const { return m_Keys[i]; }
+
+    // -1 if the key has no box
+    int Find(int key) const
+    {
+        auto it = m_Index.find(key);
+        return (it == m_Index.end()) ? -1 : int(it->second);
+    }
+
+    // 같은 key면 덮어쓴다 (스냅샷/재전송). Returns the index.
+    size_t Spawn(int key, const Vector3& pos)
+    {
+        size_t i;
+        auto it = m_Index.find(key);
+        if (it != m_Index.end())
+        {
+            i = it->second;
+        }
+        else
+        {
+            i = Size();
+            m_Index.emplace(key, i);
+            m_Keys.push_back(key);
+            m_Paths.emplace_back();
+            m_States.emplace_back();
+            ResizeLanes(Size());
+        }
+
+        m_PosX[i] = m_TargetX[i] = pos.x;
+        m_PosZ[i] = m_TargetZ[i] = pos.z;
+        m_Speed[i] = kDefaultSpeed;
+        ClearPath(i);
+        m_States[i].Clear();
+        return i;
+    }
+
+    void Remove(int key)
+    {
+        auto it = m_Index.find(key);
+        if (it == m_Index.end())
+            return;
+
+        const size_t i = it->second;
+        const size_t last = Size() - 1;
+        m_Index.erase(it);
+
+        if (i != last)
+        {
+            m_PosX[i] = m_PosX[last];       m_PosZ[i] = m_PosZ[last];
+            m_TargetX[i] = m_TargetX[last]; m_TargetZ[i] = m_TargetZ[last];
+            m_Speed[i] = m_Speed[last];
+            m_Keys[i] = m_Keys[last];
+            m_Paths[i] = std::move(m_Paths[last]);
+            m_States[i] = m_States[last];
+            m_Index[m_Keys[i]] = i;
+        }
+
+        // 빈 lane은 0으로 : pos == target, speed 0이라 Update가 건드려도 그대로
+        m_PosX[last] = m_PosZ[last] = m_TargetX[last] = m_TargetZ[last] = m_Speed[last] = 0.0f;
+        m_Keys.pop_back();
+        m_Paths.pop_back();
+        m_States.pop_back();
+        ResizeLanes(Size());
+    }
+
+    void Clear()
+    {
+        m_Index.clear();
+        m_Keys.clear();
+        m_Paths.clear();
+        m_States.clear();
+        ResizeLanes(0);
+    }
+
+    Vector3 Pos(size_t i) const { return { m_PosX[i], 0.0f, m_PosZ[i] }; }
+    Vector3 Target(size_t i) const { return { m_TargetX[i], 0.0f, m_TargetZ[i] }; }
+
+    // 도착하면 Update가 pos = target으로 맞추므로 정확히 비교해도 된다
+    bool Moving(size_t i) const { return m_PosX[i] != m_TargetX[i] || m_PosZ[i] != m_TargetZ[i]; }
+
+    void SetTarget(size_t i, const Vector3& target)
+    {
+        const float dx = target.x - m_PosX[i];
+        const float dz = target.z - m_PosZ[i];
+        if (dx * dx + dz * dz < 1e-8f) return;
+        m_TargetX[i] = target.x;
+        m_TargetZ[i] = target.z;
+    }
+
+    // 보간 : 렌더 시각의 위치에 바로 놓는다 (걷지 않는다)
+    void Place(size_t i, const Vector3& pos)
+    {
+        m_PosX[i] = m_TargetX[i] = pos.x;
+        m_PosZ[i] = m_TargetZ[i] = pos.z;
+        ClearPath(i);
+    }
+
+    // 지금 구간(target)을 마저 간 뒤 path를 따라간다. 빈 path면 target에서 멈춤
+    void SetPath(size_t i, const std::vector<Vector3>& path)
+    {
+        m_Paths[i].points = path;
+        m_Paths[i].next = 0;
+    }
+
+    void ClearPath(size_t i)
+    {
+        m_Paths[i].points.clear();
+        m_Paths[i].next = 0;
+    }
+
+    bool HasPath(size_t i) const { return m_Paths[i].next < m_Paths[i].points.size(); }
+
+    // 다른 플레이어 : 서버 틱 시각이 붙은 MOVE 목표. 렌더 시각에 두 상태 사이를 보간
+    StateBuffer& States(size_t i) { return m_States[i]; }
+
+    void Update(float dt)
+    {
+        // 멈춘 박스만 다음 waypoint로 (분기가 많아서 따로 돈다)
+        for (size_t i = 0; i < Size(); ++i)
+        {
+            if (!Moving(i))
+                AdvancePath(i);
+        }
+
+        // 박스 4개씩 : step >= dist면 target에 붙이고, 아니면 step만큼 직선 이동
+        using namespace DirectX;
+        const XMVECTOR vdt = XMVectorReplicate(dt);
+        for (size_t i = 0; i < m_PosX.size(); i += 4)
+        {
+            XMVECTOR px = Load(m_PosX, i);
+            XMVECTOR pz = Load(m_PosZ, i);
+            const XMVECTOR tx = Load(m_TargetX, i);
+            const XMVECTOR tz = Load(m_TargetZ, i);
+
+            const XMVECTOR dx = XMVectorSubtract(tx, px);
+            const XMVECTOR dz = XMVectorSubtract(tz, pz);
+            const XMVECTOR dist = XMVectorSqrt(XMVectorMultiplyAdd(dx, dx, XMVectorMultiply(dz, dz)));
+            const XMVECTOR step = XMVectorMultiply(Load(m_Speed, i), vdt);
+            const XMVECTOR arrived = XMVectorGreaterOrEqual(step, dist);
+            const XMVECTOR t = XMVectorDivide(step, dist); // dist 0인 lane은 arrived라 버려진다
+
+            px = XMVectorSelect(XMVectorMultiplyAdd(dx, t, px), tx, arrived);
+            pz = XMVectorSelect(XMVectorMultiplyAdd(dz, t, pz), tz, arrived);
+            Store(m_PosX, i, px);
+            Store(m_PosZ, i, pz);
+        }
+    }
+
+private:
+    struct Path
+    {
+        std::vector<Vector3> points; // waypoint (셀 중심)
+        size_t next = 0;
+    };
+
+    static DirectX::XMVECTOR Load(const std::vector<float>& v, size_t i)
+    {
+        return DirectX::XMLoadFloat4(reinterpret_cast<const DirectX::XMFLOAT4*>(v.data() + i));
+    }
+
+    static void Store(std::vector<float>& v, size_t i, DirectX::FXMVECTOR x)
+    {
+        DirectX::XMStoreFloat4(reinterpret_cast<DirectX::XMFLOAT4*>(v.data() + i), x);
+    }
+
+    // hot 배열은 4의 배수 길이. 늘어난 lane은 0
+    void ResizeLanes(size_t count)
+    {
+        const size_t lanes = (count + 3) & ~size_t(3);
+        for (auto* v : { &m_PosX, &m_PosZ, &m_TargetX, &m_TargetZ, &m_Speed })
+            v->resize(lanes, 0.0f);
+    }
+
+    bool AdvancePath(size_t i)
+    {
+        Path& path = m_Paths[i];
+        while (path.next < path.points.size())
+        {
+            SetTarget(i, path.points[path.next++]);
+            if (Moving(i)) return true;
+        }
+        return false;
+    }
+
+    // hot
+    std::vector<float> m_PosX, m_PosZ;
+    std::vector<float> m_TargetX, m_TargetZ;
+    std::vector<float> m_Speed;
+
+    // cold
+    std::vector<int>         m_Keys;
+    std::vector<Path>        m_Paths;
+    std::vector<StateBuffer> m_States;
+    std::unordered_map<int, size_t> m_Index; // key -> index
+};
@@ -2,24 +2,52 @@
 #define NOMINMAX
 #include <Windows.h>
 #include <Windowsx.h>
+#include <shellapi.h>
+#include <timeapi.h>
 
 #include <algorithm>
 #include <vector>
 #include <queue>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <limits>
 #include <wrl.h>
 #include <d3d11.h>
-#include <dxgi.h>
+#include <dxgi1_3.h>
+#ifdef SHADER_HOT_RELOAD
 #include <d3dcompiler.h>
+#endif
 #include <SimpleMath.h>
-#include <WICTextureLoader.h>
 #include <DDSTextureLoader.h>
 #include <chrono> 
 #include <filesystem>
 #include "AsyncClient.h"
+#include "GridMap.h"
+#include "PathPlanner.h"
+#include "Frustum.h"
+#include "Interpolation.h"
+#include "BoxStore.h"
+#include "AssetLoader.h"
+#include "FrameProfiler.h"
+#include "TripleBuffer.h"
+
+// 빌드 때 fxc가 만든 셰이더 bytecode ($(IntDir)Shaders, D3DBoxApp.vcxproj의 ShaderHeaders)
+#include "BasicColorVS.h"
+#include "BasicColorPS.h"
+#include "BasicTexVS.h"
+#include "BasicTexPS.h"
+#include "BasicSkyVS.h"
+#include "BasicSkyPS.h"
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "shell32.lib")
+#pragma comment(lib, "winmm.lib")
+#ifdef SHADER_HOT_RELOAD
 #pragma comment(lib, "d3dcompiler.lib")
+#endif
 
 using Microsoft::WRL::ComPtr;
 using namespace DirectX;
@@ -81,59 +109,6 @@ struct Camera
     }
 };
 
-// ===========================================================
-// Box : 회전 없이 선형 이동만 (셀 중심 간 이동)
-// ===========================================================
-struct Box
-{
-    Vector3 m_Pos = Vector3::Zero;     // 현재 위치(셀 중심)
-    Vector3 m_Target = Vector3::Zero;  // 목표 위치
-    Vector3 m_Dir = Vector3::Zero;     // 단위 방향
-    bool    m_Moving = false;
-    float   m_Speed = 5.0f;            // cells/sec
-    float   m_CellSize = 1.0f;
-    Matrix  m_World = Matrix::Identity;
-
-    void Init(const Vector3& start, float cellSize)
-    {
-        m_Pos = m_Target = start;
-        m_CellSize = cellSize;
-        //m_Moving = false;
-        m_Moving = true;
-        m_World = Matrix::CreateScale(m_CellSize, 1.0f, m_CellSize) * Matrix::CreateTranslation(m_Pos);
-    }
-
-    void SetTarget(const Vector3& target)
-    {
-        //if (m_Moving) return;
-        Vector3 delta = target - m_Pos;
-        if (delta.Length() < 1e-4f) return;
-        m_Target = target;
-        m_Dir = delta; m_Dir.Normalize();
-        m_Moving = true;
-    }
-
-    void Update(float dt)
-    {
-        if (!m_Moving) return;
-
-        float dist = (m_Target - m_Pos).Length();
-        float step = m_Speed * dt;
-
-        if (step >= dist)
-        {
-            m_Pos = m_Target;
-            m_Moving = false;
-        }
-        else
-        {
-            m_Pos += m_Dir * step;
-        }
-
-        m_World = Matrix::CreateScale(m_CellSize, 1.0f, m_CellSize) * Matrix::CreateTranslation(m_Pos);
-    }
-};
-
 // ===========================================================
 // Vertex / Constant Buffers
 // ===========================================================
@@ -144,6 +119,40 @@ struct VertexP { Vector3 pos; };
 struct CBVS { Matrix gWorld; Matrix gViewProj; };
 struct CBPS { Vector3 lightPos; float lightRange; Vector3 lightColor; float pad; Vector3 eyePos; float specPower; };
 
+// BasicTex.hlsl per-instance data (input slot 1, WORLD0..3)
+struct InstanceData { Matrix world; };
+
+// 장애물을 kCullChunkCells x kCullChunkCells 셀 단위로 묶는다. 컬링은 chunk AABB를 먼저 본다
+constexpr int kCullChunkCells = 8;
+
+struct ObstacleChunk
+{
+    std::vector<Vector3> boxes;  // 셀 중심, dense
+    std::vector<int>     cells;  // boxes[i]의 GridMap::Index
+    Vector3 min, max;            // chunk AABB (박스 높이 포함)
+};
+
+// --sim-rate : sim 스레드가 스텝마다 렌더에 넘기는 월드 (TripleBuffer 슬롯, 재사용)
+struct SimFrame
+{
+    double time = -1.0;                 // 스텝이 끝난 ClockNow, < 0 = 아직 없음
+    float  step = 0.0f;                 // s
+    std::vector<Vector3> from, to;      // 플레이어 박스 : 스텝 전 / 후 (같은 순서)
+    std::vector<ObstacleChunk> chunks;  // 장애물은 바뀐 뒤에만 다시 복사
+    size_t   obstacleCount = 0;
+    uint64_t obstacleVersion = ~0ull;
+    bool  interpolation = true;         // 창 제목용 (F3, [ ])
+    float interpDelay = 0.0f;
+};
+
+struct CullStats
+{
+    UINT chunksTested = 0;
+    UINT chunksCulled = 0;
+    UINT drawn = 0;
+    UINT culled = 0;
+};
+
 // ===========================================================
 // App
 // ===========================================================
@@ -153,9 +162,33 @@ struct App
     std::unique_ptr<boost::asio::io_context> m_IO;
     std::shared_ptr<AsyncClient> m_Client;
     std::thread m_NetThread;
+    std::vector<Protocol::Message> m_NetEvents; // ProcessNetwork scratch, reused every frame
+
+    // --record <file> : 받은 것을 남긴다. --replay <file> [--replay-pace original] : 서버 없이 다시 넣는다
+    // (wWinMain이 Init 전에 채운다)
+    std::filesystem::path m_RecordFile;
+    std::filesystem::path m_ReplayFile;
+    bool     m_ReplayPaced = false;
+    bool     m_ReplayReported = false;
+    double   m_ReplayStart = 0.0;
+    uint64_t m_ReplayFrames = 0;
+    uint64_t m_ReplayMessages = 0;
 
     int m_MySessionKey = -1;
 
+    // 내 박스 예측 : 클릭 즉시 움직이고, MOVE_ACK로 서버 상태와 맞춘다
+    struct PendingMove { int32_t seq; int16_t x, z; };
+    std::deque<PendingMove> m_PendingMoves; // 보냈지만 아직 ACK 안 온 MOVE (seq 순)
+    int32_t m_NextMoveSeq = 1;              // 0은 "seq 없음"
+    static constexpr size_t kMaxPendingMoves = 64;
+
+    // 다른 플레이어 보간 (F3 : on/off, [ / ] : 지연 조절)
+    bool        m_UseInterpolation = true;
+    float       m_InterpDelay = 0.1f;   // s. 틱 간격 + 지터보다 크게 (30Hz면 3틱)
+    ServerClock m_ServerClock;
+    double      m_BatchTime = -1.0;     // 마지막 TICK의 서버 시각, -1 = 틱 없음 (즉시 모드)
+    Vector3 m_OwnGoal = Vector3::Zero;      // 내 박스가 향하는 셀 (예측 포함)
+
     // D3D11 Core
     ComPtr<IDXGISwapChain> m_SwapChain;
     ComPtr<ID3D11Device> m_Device;
@@ -175,6 +208,10 @@ struct App
     ComPtr<ID3D11Buffer> m_BoxVB, m_BoxIB;
     UINT m_GridVertexCount = 0, m_BoxIndexCount = 0;
 
+    // Box instancing : 장애물 + 플레이어 월드 행렬을 프레임당 한 번 올린다
+    ComPtr<ID3D11Buffer> m_InstanceVB;
+    UINT m_InstanceCapacity = 0;
+
     // Skybox
     ComPtr<ID3D11Buffer> m_SkyVB, m_SkyIB;
     ComPtr<ID3D11ShaderResourceView> m_SkySRV;
@@ -186,18 +223,59 @@ struct App
     // Texture & Samplers
     ComPtr<ID3D11ShaderResourceView> m_TexSRV;        // 플레이어 박스
     ComPtr<ID3D11ShaderResourceView> m_ObstacleSRV;   // 장애물 박스
+    AssetLoader m_Assets; // 텍스처 (워커 스레드) : 다 오기 전의 프레임은 텍스처 없이 그린다
     ComPtr<ID3D11SamplerState>       m_Sampler;       // WRAP, Linear
     ComPtr<ID3D11SamplerState>       m_ObstacleSampler; // CLAMP, Linear(또는 Point)
 
     // Scene
     Camera m_Camera;
 
-    std::unordered_map<int, Box> m_Boxes;
+    BoxStore m_Boxes;  // 플레이어 박스 (session key -> SoA index)
     int m_MyId = -1;   // 내 블록 id (서버가 SPAWN으로 부여)
 
     // Grid map & obstacles
-    std::vector<std::vector<int>> m_GridFlags;  // 0=empty,1=blocked
-    std::vector<Box>              m_ObstacleBoxes;
+    GridMap                       m_Grid;
+    std::vector<ObstacleChunk>    m_ObstacleChunks; // row-major, m_ChunkCols x m_ChunkRows
+    int                           m_ChunkCols = 0;
+    int                           m_ChunkRows = 0;
+    std::vector<int>              m_ObstacleSlot;   // cell -> 자기 chunk의 boxes index, -1 = 없음
+    size_t                        m_ObstacleCount = 0;
+
+    // Frustum culling (F2 : on/off)
+    bool      m_UseCulling = true;
+    Frustum   m_Frustum;
+    CullStats m_CullStats;     // 지난 프레임
+    float     m_StatsTimer = 0.0f;
+
+    // Profiler (F4 : 창 제목 + 2초마다 디버그 출력, F6 : frame_profile.csv)
+    FrameProfiler m_Profiler;
+    bool          m_ShowProfile = false;
+    float         m_ProfileTimer = 0.0f;
+
+    // --sim-rate <hz> : 고정 스텝 시뮬레이션 스레드 (0 = 끔 : 프레임마다 가변 dt로 Update).
+    // sim 스레드가 네트워크 / 박스 / 경로 / 장애물을 갖고, 렌더는 TripleBuffer로 받은 마지막
+    // 스텝을 보간해서 그린다. 입력과 토글은 Post로 넘긴다. 스왑 체인은 frame latency waitable
+    int                    m_SimRate = 0;
+    std::thread            m_SimThread;
+    std::atomic<bool>      m_SimStop{ false };
+    std::mutex             m_SimMutex;
+    std::vector<std::function<void()>> m_SimCommands; // UI -> sim (m_SimMutex)
+    std::vector<std::function<void()>> m_SimRunning;  // sim scratch
+    TripleBuffer<SimFrame> m_SimFrames;
+    uint64_t               m_ObstacleVersion = 0;     // 장애물이 바뀔 때마다 +1
+    FrameProfiler          m_SimProfiler;             // 스텝 단위, CPU만 (sim 스레드)
+    bool                   m_SimReport = false;       // F4 (sim 스레드)
+    float                  m_SimReportTimer = 0.0f;
+    HANDLE                 m_FrameLatency = nullptr;
+    UINT                   m_SwapChainFlags = 0;
+    std::vector<Vector3>   m_DrawPlayers;             // Render가 그릴 플레이어 위치
+
+    // Pathfinding (F1 : on/off)
+    bool m_UsePathfinding = true;
+    std::unordered_map<int, std::unique_ptr<PathPlanner>> m_Planners; // 목표에 아직 못 간 박스만
+    std::vector<std::unique_ptr<PathPlanner>> m_PlannerPool;          // 셀 배열 재사용
+    std::vector<int>     m_PathCells;   // scratch
+    std::vector<Vector3> m_PathPoints;  // scratch
 
 
     // Window / Grid
@@ -217,6 +295,12 @@ struct App
 
     ~App()
     {
+        m_SimStop.store(true, std::memory_order_release);
+        if (m_SimThread.joinable())
+            m_SimThread.join();
+        if (m_FrameLatency)
+            CloseHandle(m_FrameLatency);
+
         SendDespawnRequestToServer();
 
         if (m_IO)
@@ -257,7 +341,9 @@ struct App
         sd.OutputWindow = hWnd;
         sd.Windowed = TRUE;
         sd.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-        sd.Flags = 0; // ALLOW_MODE_SWITCH 사용 금지
+        // --sim-rate : Present가 vsync에 막히는 대신 프레임 처음에 waitable object를 기다린다
+        m_SwapChainFlags = (m_SimRate > 0) ? DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT : 0;
+        sd.Flags = m_SwapChainFlags; // ALLOW_MODE_SWITCH 사용 금지
 
         D3D_FEATURE_LEVEL fl{};
         HRESULT hr = D3D11CreateDeviceAndSwapChain(
@@ -280,15 +366,57 @@ struct App
             return false;
         }
 
+        // 큐에 프레임 하나만 : 기다린 직후의 입력과 sim 상태가 다음 vsync에 나간다
+        if (m_SwapChainFlags != 0)
+        {
+            ComPtr<IDXGISwapChain2> swapChain2;
+            if (SUCCEEDED(m_SwapChain.As(&swapChain2)) && SUCCEEDED(swapChain2->SetMaximumFrameLatency(1)))
+                m_FrameLatency = swapChain2->GetFrameLatencyWaitableObject();
+        }
+
+        if (!m_Profiler.Init(m_Device.Get()))
+            OutputDebugString(L"[Profile] timestamp queries unavailable, CPU only\n");
+
+        // -------------------------------------------------
+        // Network (Asio)
+        // 리소스보다 먼저 : 접속 / ASSIGN / 스냅샷이 아래 초기화와 텍스처 로딩에 겹친다
+        // (이벤트는 SPSC 큐에 쌓이고, 가득 차면 소켓 읽기가 기다린다)
+        // -------------------------------------------------
+        m_IO = std::make_unique<boost::asio::io_context>();
+        m_NetEvents.reserve(8192);
+        //m_Client = std::make_shared<AsyncClient>(*m_IO, "127.0.0.1", 8080); //로컬
+        //m_Client = std::make_shared<AsyncClient>(*m_IO, "172.21.1.29", 8080);//황
+        m_Client = std::make_shared<AsyncClient>(*m_IO, "172.21.1.35", 8080);//장
+        if (!m_ReplayFile.empty())
+        {
+            if (!m_Client->Replay(m_ReplayFile, m_ReplayPaced))
+                OutputDebugString(L"[Replay] open failed\n");
+            m_ReplayStart = ClockNow();
+        }
+        else
+        {
+            if (!m_RecordFile.empty() && !m_Client->Record(m_RecordFile))
+                OutputDebugString(L"[Record] open failed\n");
+            m_Client->Start();
+        }
+
+        m_NetThread = std::thread([this]()
+            {
+                m_IO->run();
+            });
+
         // -------------------------------------------------
         // D3D Resources
+        // 텍스처는 Load*가 워커에 맡기고 바로 돌아온다 (UpdateAndDraw의 m_Assets.Poll이 마무리)
         // -------------------------------------------------
         CreateRTVDSV();
 
-        if (!CreateShaders())     return false;
-        if (!CreateSkyShader())   return false;
+        const ShaderSet shaders = EmbeddedShaders();
+        if (!CreateShaders(shaders))     return false;
+        if (!CreateSkyShader(shaders))   return false;
 
         CreateConstantBuffer();
+        EnsureInstanceBuffer(0);
         CreateGridVB();
         CreateBoxMesh();
 
@@ -304,22 +432,24 @@ struct App
         // -------------------------------------------------
         m_Camera.Init((float)m_Width, (float)m_Height);
 
-        const int gridSize = m_HalfCells * 2 + 1;
-        m_GridFlags.assign(gridSize, std::vector<int>(gridSize, 0));
-
-        // -------------------------------------------------
-        // Network (Asio)
-        // -------------------------------------------------
-        m_IO = std::make_unique<boost::asio::io_context>();
-        //m_Client = std::make_shared<AsyncClient>(*m_IO, "127.0.0.1", 8080); //로컬
-        //m_Client = std::make_shared<AsyncClient>(*m_IO, "172.21.1.29", 8080);//황
-        m_Client = std::make_shared<AsyncClient>(*m_IO, "172.21.1.35", 8080);//장
-        m_Client->Start();
+        m_Grid.Init(m_HalfCells, m_CellSize);
+        m_ObstacleSlot.assign(size_t(m_Grid.Width()) * m_Grid.Height(), -1);
+        CreateObstacleChunks();
 
-        m_NetThread = std::thread([this]()
-            {
-                m_IO->run();
-            });
+        // 월드가 준비된 뒤에 : 이제부터 시뮬레이션 상태는 sim 스레드 것
+        if (m_SimRate > 0)
+        {
+            // 첫 스텝이 나오기 전의 프레임도 chunk 배열은 그리드 크기 그대로여야 한다 (CullObstacles)
+            m_SimFrames.InitSlots([this](SimFrame& f)
+                {
+                    f.chunks = m_ObstacleChunks;
+                    f.obstacleCount = m_ObstacleCount;
+                    f.obstacleVersion = m_ObstacleVersion;
+                    f.interpolation = m_UseInterpolation;
+                    f.interpDelay = m_InterpDelay;
+                });
+            m_SimThread = std::thread([this]() { SimLoop(); });
+        }
 
 
         wchar_t path[MAX_PATH]{};
@@ -350,27 +480,89 @@ struct App
         m_Device->CreateDepthStencilView(m_DSVTex.Get(), nullptr, m_DSV.GetAddressOf());
     }
 
-    bool CreateShaders()
+    // -------------------------------------------------
+    // Shaders
+    // 기본은 빌드 때 만든 bytecode : 실행할 때 컴파일하지 않는다 (런타임 컴파일러도 필요 없다).
+    // SHADER_HOT_RELOAD (Debug)면 F5가 작업 폴더의 .hlsl을 다시 컴파일해서 바꿔 끼운다
+    // -------------------------------------------------
+    struct ShaderCode
+    {
+        const void* data = nullptr;
+        size_t size = 0;
+        ComPtr<ID3DBlob> blob; // 런타임 컴파일한 것 (data가 가리킨다)
+    };
+
+    struct ShaderSet
+    {
+        ShaderCode colorVS, colorPS, texVS, texPS, skyVS, skyPS;
+    };
+
+    template <size_t N>
+    static ShaderCode Embedded(const BYTE (&code)[N])
+    {
+        ShaderCode c;
+        c.data = code;
+        c.size = N;
+        return c;
+    }
+
+    static ShaderSet EmbeddedShaders()
     {
-        ComPtr<ID3DBlob> vsb, psb, err;
+        ShaderSet s;
+        s.colorVS = Embedded(g_BasicColorVS);
+        s.colorPS = Embedded(g_BasicColorPS);
+        s.texVS = Embedded(g_BasicTexVS);
+        s.texPS = Embedded(g_BasicTexPS);
+        s.skyVS = Embedded(g_BasicSkyVS);
+        s.skyPS = Embedded(g_BasicSkyPS);
+        return s;
+    }
+
+#ifdef SHADER_HOT_RELOAD
+    static bool CompileShader(const wchar_t* file, const char* entry, const char* target, ShaderCode& out)
+    {
+        ComPtr<ID3DBlob> err;
         UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
 #if _DEBUG
         flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
-        // Grid color
-        if (FAILED(D3DCompileFromFile(L"BasicColor.hlsl", nullptr, nullptr,
-            "VSMain", "vs_5_0", flags, 0, vsb.GetAddressOf(), err.GetAddressOf())))
+        if (FAILED(D3DCompileFromFile(file, nullptr, nullptr,
+            entry, target, flags, 0, out.blob.ReleaseAndGetAddressOf(), err.GetAddressOf())))
         {
             if (err) OutputDebugStringA((char*)err->GetBufferPointer()); return false;
         }
-        m_Device->CreateVertexShader(vsb->GetBufferPointer(), vsb->GetBufferSize(), nullptr, m_VSColor.GetAddressOf());
+        out.data = out.blob->GetBufferPointer();
+        out.size = out.blob->GetBufferSize();
+        return true;
+    }
 
-        if (FAILED(D3DCompileFromFile(L"BasicColor.hlsl", nullptr, nullptr,
-            "PSMain", "ps_5_0", flags, 0, psb.GetAddressOf(), err.ReleaseAndGetAddressOf())))
+    // F5 : 하나라도 컴파일이 안 되면 지금 셰이더를 그대로 쓴다
+    void ReloadShaders()
+    {
+        ShaderSet s;
+        const bool compiled =
+            CompileShader(L"BasicColor.hlsl", "VSMain", "vs_5_0", s.colorVS) &&
+            CompileShader(L"BasicColor.hlsl", "PSMain", "ps_5_0", s.colorPS) &&
+            CompileShader(L"BasicTex.hlsl", "VSMain", "vs_5_0", s.texVS) &&
+            CompileShader(L"BasicTex.hlsl", "PSMain", "ps_5_0", s.texPS) &&
+            CompileShader(L"BasicSkyCubeMap.hlsl", "VSMain", "vs_5_0", s.skyVS) &&
+            CompileShader(L"BasicSkyCubeMap.hlsl", "PSMain", "ps_5_0", s.skyPS);
+
+        if (!compiled || !CreateShaders(s) || !CreateSkyShader(s))
         {
-            if (err) OutputDebugStringA((char*)err->GetBufferPointer()); return false;
+            OutputDebugString(L"[Shader] reload failed\n");
+            return;
         }
-        m_Device->CreatePixelShader(psb->GetBufferPointer(), psb->GetBufferSize(), nullptr, m_PSColor.GetAddressOf());
+        OutputDebugString(L"[Shader] reloaded\n");
+    }
+#endif
+
+    bool CreateShaders(const ShaderSet& s)
+    {
+        // Grid color
+        if (FAILED(m_Device->CreateVertexShader(s.colorVS.data, s.colorVS.size, nullptr, m_VSColor.ReleaseAndGetAddressOf())) ||
+            FAILED(m_Device->CreatePixelShader(s.colorPS.data, s.colorPS.size, nullptr, m_PSColor.ReleaseAndGetAddressOf())))
+            return false;
 
         D3D11_INPUT_ELEMENT_DESC ilColor[] =
         {
@@ -378,62 +570,41 @@ struct App
             { "COLOR",    0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(VertexPC, col), D3D11_INPUT_PER_VERTEX_DATA, 0 },
         };
         m_Device->CreateInputLayout(ilColor, _countof(ilColor),
-            vsb->GetBufferPointer(), vsb->GetBufferSize(), m_InputLayoutColor.GetAddressOf());
+            s.colorVS.data, s.colorVS.size, m_InputLayoutColor.ReleaseAndGetAddressOf());
 
         // Box texture+normal
-        if (FAILED(D3DCompileFromFile(L"BasicTex.hlsl", nullptr, nullptr,
-            "VSMain", "vs_5_0", flags, 0, vsb.ReleaseAndGetAddressOf(), err.ReleaseAndGetAddressOf())))
-        {
-            if (err) OutputDebugStringA((char*)err->GetBufferPointer()); return false;
-        }
-        m_Device->CreateVertexShader(vsb->GetBufferPointer(), vsb->GetBufferSize(), nullptr, m_VSTex.GetAddressOf());
-
-        if (FAILED(D3DCompileFromFile(L"BasicTex.hlsl", nullptr, nullptr,
-            "PSMain", "ps_5_0", flags, 0, psb.ReleaseAndGetAddressOf(), err.ReleaseAndGetAddressOf())))
-        {
-            if (err) OutputDebugStringA((char*)err->GetBufferPointer()); return false;
-        }
-        m_Device->CreatePixelShader(psb->GetBufferPointer(), psb->GetBufferSize(), nullptr, m_PSTex.GetAddressOf());
+        if (FAILED(m_Device->CreateVertexShader(s.texVS.data, s.texVS.size, nullptr, m_VSTex.ReleaseAndGetAddressOf())) ||
+            FAILED(m_Device->CreatePixelShader(s.texPS.data, s.texPS.size, nullptr, m_PSTex.ReleaseAndGetAddressOf())))
+            return false;
 
         D3D11_INPUT_ELEMENT_DESC ilTexN[] =
         {
             { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(VertexPTN,pos),    D3D11_INPUT_PER_VERTEX_DATA, 0 },
             { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, offsetof(VertexPTN,uv),     D3D11_INPUT_PER_VERTEX_DATA, 0 },
             { "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(VertexPTN,normal), D3D11_INPUT_PER_VERTEX_DATA, 0 },
+            { "WORLD",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1,  0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "WORLD",    1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "WORLD",    2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+            { "WORLD",    3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 48, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
         };
         m_Device->CreateInputLayout(ilTexN, _countof(ilTexN),
-            vsb->GetBufferPointer(), vsb->GetBufferSize(), m_InputLayoutTex.GetAddressOf());
+            s.texVS.data, s.texVS.size, m_InputLayoutTex.ReleaseAndGetAddressOf());
 
         return true;
     }
 
-    bool CreateSkyShader()
+    bool CreateSkyShader(const ShaderSet& s)
     {
-        ComPtr<ID3DBlob> vsb, psb, err;
-        UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
-#if _DEBUG
-        flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
-        if (FAILED(D3DCompileFromFile(L"BasicSkyCubeMap.hlsl", nullptr, nullptr,
-            "VSMain", "vs_5_0", flags, 0, vsb.GetAddressOf(), err.GetAddressOf())))
-        {
-            if (err) OutputDebugStringA((char*)err->GetBufferPointer()); return false;
-        }
-        m_Device->CreateVertexShader(vsb->GetBufferPointer(), vsb->GetBufferSize(), nullptr, m_VSSky.GetAddressOf());
-
-        if (FAILED(D3DCompileFromFile(L"BasicSkyCubeMap.hlsl", nullptr, nullptr,
-            "PSMain", "ps_5_0", flags, 0, psb.GetAddressOf(), err.ReleaseAndGetAddressOf())))
-        {
-            if (err) OutputDebugStringA((char*)err->GetBufferPointer()); return false;
-        }
-        m_Device->CreatePixelShader(psb->GetBufferPointer(), psb->GetBufferSize(), nullptr, m_PSSky.GetAddressOf());
+        if (FAILED(m_Device->CreateVertexShader(s.skyVS.data, s.skyVS.size, nullptr, m_VSSky.ReleaseAndGetAddressOf())) ||
+            FAILED(m_Device->CreatePixelShader(s.skyPS.data, s.skyPS.size, nullptr, m_PSSky.ReleaseAndGetAddressOf())))
+            return false;
 
         D3D11_INPUT_ELEMENT_DESC ilSky[] =
         {
             { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
         };
         if (FAILED(m_Device->CreateInputLayout(ilSky, _countof(ilSky),
-            vsb->GetBufferPointer(), vsb->GetBufferSize(), m_InputLayoutSky.GetAddressOf())))
+            s.skyVS.data, s.skyVS.size, m_InputLayoutSky.ReleaseAndGetAddressOf())))
         {
             OutputDebugString(L"[Sky] InputLayout failed\n");
             return false;
@@ -476,10 +647,19 @@ struct App
 
     void LoadSkyTexture()
     {
-        HRESULT hr = CreateDDSTextureFromFile(
-            m_Device.Get(), L"skybox.dds",
-            nullptr, m_SkySRV.GetAddressOf());
-        if (FAILED(hr)) OutputDebugString(L"[Sky] skybox.dds load failed\n");
+        // DDS는 device만 쓰니 워커가 SRV까지 만든다
+        ComPtr<ID3D11Device> device = m_Device;
+        m_Assets.Add(
+            [device]()
+            {
+                ComPtr<ID3D11ShaderResourceView> srv;
+                HRESULT hr = CreateDDSTextureFromFile(
+                    device.Get(), L"skybox.dds",
+                    nullptr, srv.GetAddressOf());
+                if (FAILED(hr)) OutputDebugString(L"[Sky] skybox.dds load failed\n");
+                return srv;
+            },
+            [this](ComPtr<ID3D11ShaderResourceView> srv) { m_SkySRV = std::move(srv); });
 
         D3D11_SAMPLER_DESC sd{};
         sd.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
@@ -521,6 +701,32 @@ struct App
         m_Device->CreateBuffer(&pbd, nullptr, m_CBPS.GetAddressOf());
     }
 
+    // 필요한 인스턴스 수보다 작으면 2배씩 키워서 다시 만든다
+    void EnsureInstanceBuffer(UINT count)
+    {
+        if (m_InstanceVB && count <= m_InstanceCapacity)
+            return;
+
+        UINT capacity = (std::max)(m_InstanceCapacity, 1024u);
+        while (capacity < count)
+            capacity *= 2;
+
+        D3D11_BUFFER_DESC bd{};
+        bd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+        bd.ByteWidth = sizeof(InstanceData) * capacity;
+        bd.Usage = D3D11_USAGE_DYNAMIC;
+        bd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+        m_InstanceVB.Reset();
+        if (FAILED(m_Device->CreateBuffer(&bd, nullptr, m_InstanceVB.GetAddressOf())))
+        {
+            OutputDebugString(L"[Instance] CreateBuffer failed\n");
+            m_InstanceCapacity = 0;
+            return;
+        }
+        m_InstanceCapacity = capacity;
+    }
+
     void CreateGridVB()
     {
         const int   N = m_HalfCells;
@@ -616,9 +822,12 @@ struct App
 
     void LoadBoxTexture()
     {
-        CreateWICTextureFromFile(
-            m_Device.Get(), m_Context.Get(),
-            L"BoxTexture.png", nullptr, m_TexSRV.GetAddressOf());
+        m_Assets.Add(
+            []() { return DecodeImageFile(L"BoxTexture.png"); },
+            [this](const DecodedImage& img)
+            {
+                CreateTexture(m_Device.Get(), m_Context.Get(), img, m_TexSRV.ReleaseAndGetAddressOf());
+            });
 
         // Box용 샘플러 (WRAP, Linear)
         D3D11_SAMPLER_DESC sd{};
@@ -629,10 +838,13 @@ struct App
 
     void LoadObstacleTextureAndSampler()
     {
-        HRESULT hr = CreateWICTextureFromFile(
-            m_Device.Get(), m_Context.Get(),
-            L"obstacle.png", nullptr, m_ObstacleSRV.GetAddressOf());
-        if (FAILED(hr)) OutputDebugString(L"[Texture] obstacle.png load failed\n");
+        m_Assets.Add(
+            []() { return DecodeImageFile(L"obstacle.png"); },
+            [this](const DecodedImage& img)
+            {
+                HRESULT hr = CreateTexture(m_Device.Get(), m_Context.Get(), img, m_ObstacleSRV.ReleaseAndGetAddressOf());
+                if (FAILED(hr)) OutputDebugString(L"[Texture] obstacle.png load failed\n");
+            });
 
         // 장애물용 샘플러 (CLAMP, Linear) — 픽셀아트면 POINT 권장
         D3D11_SAMPLER_DESC sd2{};
@@ -687,25 +899,6 @@ struct App
         return { cx, 0.0f, cz };
     }
 
-    bool WorldToGrid(const Vector3& pos, int& gx, int& gz)
-    {
-        float s = m_CellSize;
-        float half = m_HalfCells * s;
-        gx = int(floorf((pos.x + half) / s));
-        gz = int(floorf((pos.z + half) / s));
-        int gridSize = m_HalfCells * 2 + 1;
-        return !(gx < 0 || gz < 0 || gx >= gridSize || gz >= gridSize);
-    }
-
-    Vector3 GridToWorld(int gx, int gz)
-    {
-        float s = m_CellSize;
-        float half = m_HalfCells * s;
-        float wx = -half + gx * s + s * 0.5f;
-        float wz = -half + gz * s + s * 0.5f;
-        return { wx, 0.0f, wz };
-    }
-
     // === Render ===
     void RenderSkybox()
     {
@@ -747,112 +940,170 @@ struct App
 
     void ProcessNetwork()
     {
-        std::string line;
-
-        while (m_Client->PopLine(line))
+        // 프레임당 한 번, 쌓인 이벤트를 통째로 꺼낸다
+        const bool replayDone = !m_ReplayFile.empty() && m_Client->ReplayDone(); // 꺼내기 전에 : 이게 마지막
+        m_Client->PopMessages(m_NetEvents);
+        const double now = ClockNow();
+        if (!m_ReplayFile.empty() && !m_ReplayReported)
+            ReportReplay(replayDone, now);
+
+        for (const Protocol::Message& msg : m_NetEvents)
         {
-            std::istringstream iss(line);
-            std::string cmd;
-            iss >> cmd;
-
+            switch (msg.op)
+            {
             // ---------------------------------
             // ASSIGN <sessionKey>
             // ---------------------------------
-            if (cmd == "ASSIGN")
-            {
-                iss >> m_MySessionKey;
+            case Protocol::Op::Assign:
+                m_MySessionKey = msg.key;
                 // 내 세션 키 확정
-            }
+                break;
+
+            // ---------------------------------
+            // RESUME <sessionKey> : 끊겼다 다시 붙어서 같은 세션을 이어받았다 (v3)
+            // ---------------------------------
+            case Protocol::Op::Resume:
+                // 월드는 그대로 두고 바뀐 것만 받는다 (SPAWN / DESPAWN / 장애물 편집 뒤에 SNAPSHOT_END).
+                // 끊긴 동안의 예측 MOVE는 ACK가 오지 않는다 : 내 SPAWN이 서버 위치로 되돌린다
+                m_MySessionKey = msg.key;
+                m_PendingMoves.clear();
+                break;
 
             // ---------------------------------
             // SNAPSHOT_BEGIN
             // ---------------------------------
-            else if (cmd == "SNAPSHOT_BEGIN")
-            {
-                // 서버 기준 월드 재구성
-                m_Boxes.clear();
+            case Protocol::Op::SnapshotBegin:
+                // 서버 기준 월드 재구성 (장애물도 스냅샷으로 다시 온다)
+                m_Boxes.Clear();
+                m_PendingMoves.clear();
+                m_ServerClock.Reset(); // 서버가 바뀌었을 수 있다 (틱 번호 재시작)
+                m_BatchTime = -1.0;
+                ClearObstacles();
 
                 // ★ m_MySessionKey는 절대 초기화하지 않는다
-            }
+                break;
 
             // ---------------------------------
             // SNAPSHOT_END
             // ---------------------------------
-            else if (cmd == "SNAPSHOT_END")
-            {
+            case Protocol::Op::SnapshotEnd:
                 // 현재 단계에서는 추가 처리 없음
-            }
+                break;
 
             // ---------------------------------
             // SPAWN <sessionKey> <cellX> <cellZ>
             // ---------------------------------
-            else if (cmd == "SPAWN")
+            case Protocol::Op::Spawn:
             {
-                int key, x, z;
-                iss >> key >> x >> z;
-
                 Vector3 pos(
-                    (x + 0.5f) * m_CellSize,
+                    (msg.x + 0.5f) * m_CellSize,
                     0.0f,
-                    (z + 0.5f) * m_CellSize
+                    (msg.z + 0.5f) * m_CellSize
                 );
 
-                Box box;
-                box.Init(pos, m_CellSize);
-
                 // 동일 key면 덮어쓰기 (스냅샷/재전송 대응)
-                m_Boxes[key] = box;
+                m_Boxes.Spawn(msg.key, pos);
+                if (msg.key == m_MySessionKey)
+                    m_OwnGoal = pos;
+                break;
             }
 
             // ---------------------------------
-            // DESPAWN <sessionKey> <cellX> <cellZ>
+            // DESPAWN <sessionKey>
             // ---------------------------------
-            else if (cmd == "DESPAWN")
-            {
-                int key, x, z;
-                iss >> key >> x >> z;
-
-                Vector3 pos(
-                    (x + 0.5f) * m_CellSize,
-                    0.0f,
-                    (z + 0.5f) * m_CellSize
-                );
-
+            case Protocol::Op::Despawn:
                 // 왜 안지워지지?
                 // 왜 안생기지라는 표현이 맞긴 하겠네
-                m_Boxes.erase(key);
-            }
+                m_Boxes.Remove(msg.key);
+                break;
 
             // ---------------------------------
             // MOVE <sessionKey> <cellX> <cellZ>
             // ---------------------------------
-            else if (cmd == "MOVE")
+            case Protocol::Op::Move:
             {
-                int key, x, z;
-                iss >> key >> x >> z;
+                const int index = m_Boxes.Find(msg.key);
+                if (index < 0)
+                    break;
 
-                auto it = m_Boxes.find(key);
-                if (it == m_Boxes.end())
-                    continue;
+                // 내 박스는 예측으로 이미 움직였다. 서버 쪽 정답은 MOVE_ACK
+                if (msg.key == m_MySessionKey)
+                    break;
 
                 Vector3 pos(
-                    (x + 0.5f) * m_CellSize,
+                    (msg.x + 0.5f) * m_CellSize,
                     0.0f,
-                    (z + 0.5f) * m_CellSize
+                    (msg.z + 0.5f) * m_CellSize
                 );
 
                 // 1단계: 즉시 위치 이동 (텔레포트)
                 //it->second.Init(pos, m_CellSize);
                 // 2단계 : 업데이트로 바꿔야 하는데...
-                it->second.SetTarget(pos);
+                //it->second.SetTarget(pos);
+                // 3단계 : 장애물을 피해 경로로 (그리드 밖이거나 F1 off면 직선)
+                // 4단계 : 틱 시각과 함께 버퍼에 넣고, Update가 렌더 시각의 위치를 보간
+                if (m_UseInterpolation && m_BatchTime >= 0.0)
+                {
+                    StateBuffer& states = m_Boxes.States(index);
+                    if (states.Empty())
+                    {
+                        // 서 있던 박스 : 한 틱 전에 지금 자리에 있었다
+                        const Vector3 from = m_Boxes.Pos(index);
+                        states.Push(EntityState{ m_BatchTime - 1.0 / m_ServerClock.Rate(),
+                            from.x / m_CellSize - 0.5f, from.z / m_CellSize - 0.5f });
+                    }
+                    states.Push(EntityState{ m_BatchTime, float(msg.x), float(msg.z) });
+                    break;
+                }
+                m_Boxes.States(index).Clear();
+                MoveBoxTo(index, pos);
+                break;
+            }
+
+            // ---------------------------------
+            // TICK <n> <rate> : 뒤따르는 MOVE 배치의 서버 시각
+            // ---------------------------------
+            case Protocol::Op::Tick:
+                m_ServerClock.OnTick(uint32_t(msg.key), msg.x, now);
+                m_BatchTime = m_ServerClock.Valid() ? m_ServerClock.TickTime(uint32_t(msg.key)) : -1.0;
+                break;
+
+            // ---------------------------------
+            // MOVE_ACK <seq> <cellX> <cellZ> : 내 MOVE를 서버가 처리한 결과
+            // ---------------------------------
+            case Protocol::Op::MoveAck:
+                ReconcileMove(msg);
+                break;
+
+            // ---------------------------------
+            // OBSTACLE_RUN <len> <cellX> <cellZ> : 스냅샷, +x 방향 len칸
+            // ---------------------------------
+            case Protocol::Op::ObstacleRun:
+                for (int i = 0; i < msg.key; ++i)
+                    SetServerObstacle(msg.x + i, msg.z, true);
+                break;
+
+            // ---------------------------------
+            // OBSTACLE_SET / OBSTACLE_CLEAR <cellX> <cellZ>
+            // ---------------------------------
+            case Protocol::Op::ObstacleSet:
+            case Protocol::Op::ObstacleClear:
+                SetServerObstacle(msg.x, msg.z, msg.op == Protocol::Op::ObstacleSet);
+                break;
+
+            default:
+                break;
             }
         }
     }
 
 
 
-    void Render()
+    // chunks / obstacleCount : 스레드 없으면 App의 것, --sim-rate면 받은 SimFrame의 것
+    void Render(const std::vector<ObstacleChunk>& chunks, size_t obstacleCount)
     {
+        m_Profiler.BeginGpu(m_Context.Get());
+
         // Clear
         float clear[4] = { 0.08f,0.09f,0.11f,1.0f };
         m_Context->OMSetRenderTargets(1, m_RTV.GetAddressOf(), m_DSV.Get());
@@ -864,82 +1115,585 @@ struct App
 
         D3D11_VIEWPORT vp{ 0,0,(FLOAT)m_Width,(FLOAT)m_Height,0,1 };
         m_Context->RSSetViewports(1, &vp);
+        m_Profiler.MarkGpu(m_Context.Get(), FrameProfiler::GpuPass::Clear);
 
         // Skybox
-        RenderSkybox();
+        {
+            FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Sky);
+            RenderSkybox();
+            m_Profiler.MarkGpu(m_Context.Get(), FrameProfiler::GpuPass::Sky);
+        }
 
         // Grid
-        m_Context->IASetInputLayout(m_InputLayoutColor.Get());
-        m_Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-        UINT strideC = sizeof(VertexPC), offsetC = 0;
-        m_Context->IASetVertexBuffers(0, 1, m_GridVB.GetAddressOf(), &strideC, &offsetC);
-        m_Context->VSSetShader(m_VSColor.Get(), nullptr, 0);
-        m_Context->PSSetShader(m_PSColor.Get(), nullptr, 0);
-        MapAndSetCB(Matrix::Identity, m_Camera.m_View * m_Camera.m_Proj);
-        m_Context->Draw(m_GridVertexCount, 0);
-
-        // Common state for textured draws
-        m_Context->IASetInputLayout(m_InputLayoutTex.Get());
-        m_Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        UINT stride2 = sizeof(VertexPTN), offset2 = 0;
-        m_Context->IASetVertexBuffers(0, 1, m_BoxVB.GetAddressOf(), &stride2, &offset2);
-        m_Context->IASetIndexBuffer(m_BoxIB.Get(), DXGI_FORMAT_R16_UINT, 0);
-        m_Context->VSSetShader(m_VSTex.Get(), nullptr, 0);
-        m_Context->PSSetShader(m_PSTex.Get(), nullptr, 0);
+        {
+            FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Grid);
+            m_Context->IASetInputLayout(m_InputLayoutColor.Get());
+            m_Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+            UINT strideC = sizeof(VertexPC), offsetC = 0;
+            m_Context->IASetVertexBuffers(0, 1, m_GridVB.GetAddressOf(), &strideC, &offsetC);
+            m_Context->VSSetShader(m_VSColor.Get(), nullptr, 0);
+            m_Context->PSSetShader(m_PSColor.Get(), nullptr, 0);
+            MapAndSetCB(Matrix::Identity, m_Camera.m_View * m_Camera.m_Proj);
+            m_Context->Draw(m_GridVertexCount, 0);
+            m_Profiler.MarkGpu(m_Context.Get(), FrameProfiler::GpuPass::Grid);
+        }
 
-        // Pixel shader CB
-        D3D11_MAPPED_SUBRESOURCE ms{};
-        m_Context->Map(m_CBPS.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-        {
-            auto* cb = reinterpret_cast<CBPS*>(ms.pData);
-            cb->lightPos = m_Camera.GetEyePos();
-            cb->lightRange = 20.0f;
-            cb->lightColor = Vector3(1, 1, 0.8f);
-            cb->eyePos = m_Camera.GetEyePos();
-            cb->specPower = 32.0f;
+        // Instances : 보이는 장애물 [0, obstacleCount), 보이는 플레이어 [obstacleCount, +playerCount)
+        // 버퍼는 전체 수로 잡고, 컬링하면서 바로 써 넣는다
+        UINT visibleObstacles = 0;
+        UINT playerCount = 0;
+
+        {
+            FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Cull);
+            EnsureInstanceBuffer(UINT(obstacleCount + m_DrawPlayers.size()));
+            if (m_InstanceVB)
+            {
+                D3D11_MAPPED_SUBRESOURCE ims{};
+                m_Context->Map(m_InstanceVB.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ims);
+                auto* inst = reinterpret_cast<InstanceData*>(ims.pData);
+
+                m_Frustum.Build(m_Camera.m_View * m_Camera.m_Proj);
+                m_CullStats = {};
+                visibleObstacles = CullObstacles(chunks, obstacleCount, inst);
+                playerCount = CullPlayers(inst + visibleObstacles);
+
+                m_Context->Unmap(m_InstanceVB.Get(), 0);
+            }
         }
-        m_Context->Unmap(m_CBPS.Get(), 0);
-        m_Context->PSSetConstantBuffers(1, 1, m_CBPS.GetAddressOf());
 
-        // Obstacles
-        if (!m_ObstacleBoxes.empty())
         {
-            m_Context->PSSetShaderResources(0, 1, m_ObstacleSRV.GetAddressOf());
-            m_Context->PSSetSamplers(0, 1, m_ObstacleSampler.GetAddressOf());
+            FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Draw);
+            // Common state for textured draws
+            m_Context->IASetInputLayout(m_InputLayoutTex.Get());
+            m_Context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+            ID3D11Buffer* vbs[2] = { m_BoxVB.Get(), m_InstanceVB.Get() };
+            UINT strides[2] = { sizeof(VertexPTN), sizeof(InstanceData) };
+            UINT offsets[2] = { 0, 0 };
+            m_Context->IASetVertexBuffers(0, 2, vbs, strides, offsets);
+            m_Context->IASetIndexBuffer(m_BoxIB.Get(), DXGI_FORMAT_R16_UINT, 0);
+            m_Context->VSSetShader(m_VSTex.Get(), nullptr, 0);
+            m_Context->PSSetShader(m_PSTex.Get(), nullptr, 0);
+
+            // Pixel shader CB
+            D3D11_MAPPED_SUBRESOURCE ms{};
+            m_Context->Map(m_CBPS.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
+            {
+                auto* cb = reinterpret_cast<CBPS*>(ms.pData);
+                cb->lightPos = m_Camera.GetEyePos();
+                cb->lightRange = 20.0f;
+                cb->lightColor = Vector3(1, 1, 0.8f);
+                cb->eyePos = m_Camera.GetEyePos();
+                cb->specPower = 32.0f;
+            }
+            m_Context->Unmap(m_CBPS.Get(), 0);
+            m_Context->PSSetConstantBuffers(1, 1, m_CBPS.GetAddressOf());
+
+            // Obstacles (gViewProj는 Grid에서 올린 CBVS 그대로, world는 인스턴스 버퍼)
+            if (visibleObstacles > 0 && m_InstanceVB)
+            {
+                m_Context->PSSetShaderResources(0, 1, m_ObstacleSRV.GetAddressOf());
+                m_Context->PSSetSamplers(0, 1, m_ObstacleSampler.GetAddressOf());
+
+                m_Context->DrawIndexedInstanced(m_BoxIndexCount, visibleObstacles, 0, 0, 0);
+            }
+            m_Profiler.MarkGpu(m_Context.Get(), FrameProfiler::GpuPass::Obstacles);
 
-            for (auto& obs : m_ObstacleBoxes)
+            // -----------------------------
+            // Player boxes (MULTI)
+            // -----------------------------
+            if (playerCount > 0 && m_InstanceVB)
             {
-                MapAndSetCB(obs.m_World, m_Camera.m_View * m_Camera.m_Proj);
-                m_Context->DrawIndexed(m_BoxIndexCount, 0, 0);
+                m_Context->PSSetShaderResources(0, 1, m_TexSRV.GetAddressOf());
+                m_Context->PSSetSamplers(0, 1, m_Sampler.GetAddressOf());
+
+                m_Context->DrawIndexedInstanced(m_BoxIndexCount, playerCount, 0, 0, visibleObstacles);
             }
+            m_Profiler.MarkGpu(m_Context.Get(), FrameProfiler::GpuPass::Players);
         }
 
-        // -----------------------------
-        // Player boxes (MULTI)
-        // -----------------------------
-        if (!m_Boxes.empty())
+        m_Profiler.EndGpu(m_Context.Get());
+
+        FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Present);
+        m_SwapChain->Present(1, 0);
+    }
+
+
+    // -------------------------
+    // Frustum culling
+    // -------------------------
+    void CreateObstacleChunks()
+    {
+        m_ChunkCols = (m_Grid.Width() + kCullChunkCells - 1) / kCullChunkCells;
+        m_ChunkRows = (m_Grid.Height() + kCullChunkCells - 1) / kCullChunkCells;
+        m_ObstacleChunks.assign(size_t(m_ChunkCols) * m_ChunkRows, ObstacleChunk{});
+
+        const Vector3 halfCell(m_CellSize * 0.5f, 0.0f, m_CellSize * 0.5f);
+        for (int cz = 0; cz < m_ChunkRows; ++cz)
         {
-            m_Context->PSSetShaderResources(0, 1, m_TexSRV.GetAddressOf());
-            m_Context->PSSetSamplers(0, 1, m_Sampler.GetAddressOf());
+            for (int cx = 0; cx < m_ChunkCols; ++cx)
+            {
+                const int gx1 = (std::min)((cx + 1) * kCullChunkCells, m_Grid.Width()) - 1;
+                const int gz1 = (std::min)((cz + 1) * kCullChunkCells, m_Grid.Height()) - 1;
 
-            for (auto& [id, box] : m_Boxes)
+                ObstacleChunk& chunk = m_ObstacleChunks[size_t(cz) * m_ChunkCols + cx];
+                chunk.min = m_Grid.GridToWorld(cx * kCullChunkCells, cz * kCullChunkCells) - halfCell;
+                chunk.max = m_Grid.GridToWorld(gx1, gz1) + halfCell + Vector3(0.0f, 1.0f, 0.0f);
+            }
+        }
+    }
+
+    ObstacleChunk& ChunkOf(int gx, int gz)
+    {
+        return m_ObstacleChunks[size_t(gz / kCullChunkCells) * m_ChunkCols + gx / kCullChunkCells];
+    }
+
+    // 박스 메시는 x,z ±0.5, y [0, 1] (CreateBoxMesh)
+    bool IsVisible(const Vector3& pos)
+    {
+        const Vector3 ext(m_CellSize * 0.5f, 0.0f, m_CellSize * 0.5f);
+        return m_Frustum.Test(pos - ext, pos + ext + Vector3(0.0f, 1.0f, 0.0f)) != Frustum::Result::Outside;
+    }
+
+    // Scale(cell, 1, cell) * Translation(pos) 를 곱셈 없이 바로 쓴다
+    Matrix BoxWorld(const Vector3& pos) const
+    {
+        return Matrix(
+            m_CellSize, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, m_CellSize, 0.0f,
+            pos.x, pos.y, pos.z, 1.0f);
+    }
+
+    // 박스 높이 [0, 1] 안에서 frustum이 덮는 chunk 범위만 돈다 (월드 크기가 아니라 보이는 만큼).
+    // chunk가 통째로 밖이면 박스는 보지 않고, 통째로 안이면 검사 없이 모두 그린다.
+    // 빈 chunk는 평면 검사도 하지 않는다. Returns the instances written.
+    UINT CullObstacles(const std::vector<ObstacleChunk>& chunks, size_t obstacleCount, InstanceData* inst)
+    {
+        int cx0 = 0, cz0 = 0, cx1 = m_ChunkCols - 1, cz1 = m_ChunkRows - 1;
+        if (m_UseCulling)
+        {
+            Vector2 mn, mx;
+            const Matrix invVP = (m_Camera.m_View * m_Camera.m_Proj).Invert();
+            if (!Frustum::FootprintXZ(invVP, 0.0f, 1.0f, mn, mx))
             {
-                MapAndSetCB(box.m_World, m_Camera.m_View * m_Camera.m_Proj);
-                m_Context->DrawIndexed(m_BoxIndexCount, 0, 0);
+                m_CullStats.culled += UINT(obstacleCount);
+                return 0;
             }
+
+            const float chunkSize = kCullChunkCells * m_CellSize;
+            const float half = m_HalfCells * m_CellSize;
+            auto toChunk = [&](float v, int last) { return std::clamp(int(floorf((v + half) / chunkSize)), 0, last); };
+            cx0 = toChunk(mn.x, m_ChunkCols - 1); cx1 = toChunk(mx.x, m_ChunkCols - 1);
+            cz0 = toChunk(mn.y, m_ChunkRows - 1); cz1 = toChunk(mx.y, m_ChunkRows - 1);
         }
 
-        m_SwapChain->Present(1, 0);
+        UINT count = 0;
+        UINT visited = 0;
+        for (int cz = cz0; cz <= cz1; ++cz)
+        {
+            for (int cx = cx0; cx <= cx1; ++cx)
+            {
+                const ObstacleChunk& chunk = chunks[size_t(cz) * m_ChunkCols + cx];
+                visited += UINT(chunk.boxes.size());
+                if (chunk.boxes.empty())
+                    continue;
+
+                const UINT n = UINT(chunk.boxes.size());
+                const Frustum::Result r = m_UseCulling ? m_Frustum.Test(chunk.min, chunk.max) : Frustum::Result::Inside;
+                ++m_CullStats.chunksTested;
+
+                if (r == Frustum::Result::Outside)
+                {
+                    ++m_CullStats.chunksCulled;
+                    m_CullStats.culled += n;
+                    continue;
+                }
+
+                for (const Vector3& pos : chunk.boxes)
+                {
+                    if (r == Frustum::Result::Intersect && !IsVisible(pos))
+                    {
+                        ++m_CullStats.culled;
+                        continue;
+                    }
+                    inst[count++].world = BoxWorld(pos);
+                }
+            }
+        }
+        m_CullStats.culled += UINT(obstacleCount) - visited; // 범위 밖 chunk
+        m_CullStats.drawn += count;
+        return count;
     }
 
+    // 플레이어는 매 프레임 움직이므로 박스 단위로만 본다
+    UINT CullPlayers(InstanceData* inst)
+    {
+        UINT count = 0;
+        for (const Vector3& pos : m_DrawPlayers)
+        {
+            if (m_UseCulling && !IsVisible(pos))
+            {
+                ++m_CullStats.culled;
+                continue;
+            }
+            inst[count++].world = BoxWorld(pos);
+        }
+        m_CullStats.drawn += count;
+        return count;
+    }
 
-    void Update(float dt)
+    // 기록이 끝날 때까지 프레임과 메시지를 센다. 끝나면 한 번 출력
+    void ReportReplay(bool done, double now)
     {
-        ProcessNetwork();
+        ++m_ReplayFrames;
+        m_ReplayMessages += m_NetEvents.size();
+        if (!done)
+            return;
 
-        for (auto& [id, box] : m_Boxes)
+        m_ReplayReported = true;
+        const double seconds = (std::max)(now - m_ReplayStart, 1e-9);
+        char line[256];
+        std::snprintf(line, sizeof(line), "[Replay] %llu messages in %.3f s over %llu frames : %.0f msg/s, %.3f ms/frame\n",
+            (unsigned long long)m_ReplayMessages, seconds, (unsigned long long)m_ReplayFrames,
+            double(m_ReplayMessages) / seconds, seconds * 1000.0 / double(m_ReplayFrames));
+        OutputDebugStringA(line);
+    }
+
+    static double ClockNow()
+    {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // 컬링 결과를 창 제목에 (0.5초마다). F4면 프로파일 요약
+    void UpdateStatsTitle(float dt)
+    {
+        m_StatsTimer += dt;
+        m_ProfileTimer += dt;
+        if (m_StatsTimer < 0.5f)
+            return;
+        m_StatsTimer = 0.0f;
+
+        wchar_t title[256];
+        if (m_ShowProfile)
         {
-            box.Update(dt);
+            const FrameProfiler::Summary p = m_Profiler.Summarize();
+            const float present = p.cpu[size_t(FrameProfiler::CpuPhase::Present)].avg;
+            const float wait = p.cpu[size_t(FrameProfiler::CpuPhase::Wait)].avg;
+            float update = 0.0f, render = 0.0f;
+            for (size_t i = 0; i < FrameProfiler::kCpuPhases; ++i)
+            {
+                const float ms = p.cpu[i].avg;
+                (i <= size_t(FrameProfiler::CpuPhase::Paths) ? update : render) += ms;
+            }
+            swprintf_s(title, L"DX11 Grid (F4 profile, F6 csv) | frame %.2f ms p95 %.2f p99 %.2f | cpu update %.2f render %.2f present %.2f wait %.2f | gpu %.2f ms p95 %.2f",
+                p.frame.avg, p.frame.p95, p.frame.p99,
+                update, render - present - wait, present, wait,
+                p.gpuTotal.avg, p.gpuTotal.p95);
+            SetWindowTextW(m_hWnd, title);
+
+            if (m_ProfileTimer >= 2.0f)
+            {
+                m_ProfileTimer = 0.0f;
+                char report[2048];
+                FrameProfiler::Report(p, report, sizeof(report));
+                OutputDebugStringA(report);
+            }
+            return;
+        }
+
+        // 보간 설정은 sim 스레드 것 : 마지막으로 받은 스텝에 실려 온다
+        const SimFrame& sim = m_SimFrames.Front();
+        const bool interpolation = (m_SimRate > 0) ? sim.interpolation : m_UseInterpolation;
+        const float interpDelay = (m_SimRate > 0) ? sim.interpDelay : m_InterpDelay;
+        swprintf_s(title, L"DX11 Grid + Obstacles + A* (F1 path, F2 cull %s, F3 interp %s %.0fms) | MOVE %s | drawn %u culled %u | chunks %u/%u culled",
+            m_UseCulling ? L"on" : L"off",
+            interpolation ? L"on" : L"off", interpDelay * 1000.0f,
+            !m_ReplayFile.empty() ? (m_Client->ReplayDone() ? L"replay done" : L"replay") :
+            !(m_Client && m_Client->IsOpen()) ? L"offline" : m_Client->UdpUp() ? L"udp" : L"tcp",
+            m_CullStats.drawn, m_CullStats.culled, m_CullStats.chunksCulled, m_CullStats.chunksTested);
+        SetWindowTextW(m_hWnd, title);
+    }
+
+
+    // 시뮬레이션 한 번 : UI 스레드에서 프레임마다, --sim-rate면 sim 스레드에서 고정 dt로.
+    // frame이 있으면 스텝 전 / 후 박스 위치를 거기에, 없으면 m_DrawPlayers에 바로
+    void Update(float dt, FrameProfiler& profiler, SimFrame* frame = nullptr)
+    {
+        {
+            FrameProfiler::CpuScope scope(profiler, FrameProfiler::CpuPhase::Network);
+            ProcessNetwork();
+        }
+
+        const double renderTime = m_ServerClock.RenderTime(ClockNow(), m_InterpDelay);
+
+        {
+            FrameProfiler::CpuScope scope(profiler, FrameProfiler::CpuPhase::Boxes);
+            for (size_t i = 0; i < m_Boxes.Size(); ++i)
+            {
+                StateBuffer& states = m_Boxes.States(i);
+                if (states.Empty())
+                    continue;
+
+                // 보간 off로 바꿨으면 버퍼에 남은 마지막 목표로 걸어간다
+                EntityState state;
+                if (!m_UseInterpolation)
+                {
+                    if (states.TakeLatest(state))
+                        MoveBoxTo(i, Vector3((state.x + 0.5f) * m_CellSize, 0.0f, (state.z + 0.5f) * m_CellSize));
+                    continue;
+                }
+
+                float x, z;
+                if (states.Sample(renderTime, x, z))
+                {
+                    ReleasePlanner(m_Boxes.Key(i));
+                    m_Boxes.Place(i, Vector3((x + 0.5f) * m_CellSize, 0.0f, (z + 0.5f) * m_CellSize));
+                }
+            }
+            // Spawn / Remove는 ProcessNetwork에서만 : 여기서 index는 그대로다
+            if (frame)
+                CapturePlayers(frame->from);
+            m_Boxes.Update(dt);
+            CapturePlayers(frame ? frame->to : m_DrawPlayers);
+        }
+
+        FrameProfiler::CpuScope scope(profiler, FrameProfiler::CpuPhase::Paths);
+        UpdatePlanners();
+    }
+
+    void CapturePlayers(std::vector<Vector3>& out) const
+    {
+        out.resize(m_Boxes.Size());
+        for (size_t i = 0; i < out.size(); ++i)
+            out[i] = m_Boxes.Pos(i);
+    }
+
+    // === Simulation thread (--sim-rate) ===
+    static constexpr int kSimMaxLag = 5; // 이만큼 넘게 밀리면 따라잡지 않고 지금부터 다시
+
+    // 입력 -> 시뮬레이션 상태. sim 스레드가 있으면 다음 스텝 처음에, 없으면 바로 (UI 스레드)
+    void Post(std::function<void()> fn)
+    {
+        if (!m_SimThread.joinable())
+        {
+            fn();
+            return;
+        }
+        std::lock_guard<std::mutex> lock(m_SimMutex);
+        m_SimCommands.push_back(std::move(fn));
+    }
+
+    void SimLoop()
+    {
+        using clock = std::chrono::steady_clock;
+        const float dt = 1.0f / float(m_SimRate);
+        const auto step = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(dt));
+
+        timeBeginPeriod(1); // sleep_until이 1ms 단위로 깬다 (기본은 15.6ms)
+        auto next = clock::now();
+        while (!m_SimStop.load(std::memory_order_acquire))
+        {
+            SimStep(dt);
+
+            // 늦었으면 쉬지 않고 다음 스텝 (따라잡기)
+            next += step;
+            const auto now = clock::now();
+            if (now - next > step * kSimMaxLag)
+                next = now;
+            else if (next > now)
+                std::this_thread::sleep_until(next);
+        }
+        timeEndPeriod(1);
+    }
+
+    void SimStep(float dt)
+    {
+        m_SimProfiler.BeginFrame();
+        {
+            std::lock_guard<std::mutex> lock(m_SimMutex);
+            m_SimRunning.swap(m_SimCommands);
+        }
+        for (auto& fn : m_SimRunning)
+            fn();
+        m_SimRunning.clear();
+
+        SimFrame& frame = m_SimFrames.Back();
+        Update(dt, m_SimProfiler, &frame);
+        frame.time = ClockNow();
+        frame.step = dt;
+        if (frame.obstacleVersion != m_ObstacleVersion)
+        {
+            frame.chunks = m_ObstacleChunks;
+            frame.obstacleCount = m_ObstacleCount;
+            frame.obstacleVersion = m_ObstacleVersion;
+        }
+        frame.interpolation = m_UseInterpolation;
+        frame.interpDelay = m_InterpDelay;
+        m_SimFrames.Publish();
+        m_SimProfiler.EndFrame(nullptr);
+
+        // F4 : 스텝 percentile을 2초마다 디버그 출력에
+        m_SimReportTimer += dt;
+        if (m_SimReportTimer >= 2.0f)
+        {
+            m_SimReportTimer = 0.0f;
+            if (m_SimReport)
+            {
+                char report[2048];
+                FrameProfiler::Report(m_SimProfiler.Summarize(), report, sizeof(report), "Sim");
+                OutputDebugStringA(report);
+            }
+        }
+    }
+
+    // 마지막 스텝이 끝난 뒤 흐른 시간만큼 from -> to. 화면은 sim보다 최대 한 스텝 늦다
+    void InterpolateSim()
+    {
+        FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Boxes);
+        m_SimFrames.Acquire();
+        const SimFrame& f = m_SimFrames.Front();
+        m_DrawPlayers.resize(f.to.size());
+        if (f.time < 0.0)
+            return;
+
+        const float t = std::clamp(float((ClockNow() - f.time) / f.step), 0.0f, 1.0f);
+        for (size_t i = 0; i < f.to.size(); ++i)
+            m_DrawPlayers[i] = Vector3::Lerp(f.from[i], f.to[i], t);
+    }
+
+    // === Pathfinding ===
+    PathPlanner& AcquirePlanner(int key)
+    {
+        auto& planner = m_Planners[key];
+        if (!planner)
+        {
+            if (!m_PlannerPool.empty())
+            {
+                planner = std::move(m_PlannerPool.back());
+                m_PlannerPool.pop_back();
+            }
+            else
+            {
+                planner = std::make_unique<PathPlanner>();
+            }
+
+            planner->Bind(&m_Grid);
+        }
+        return *planner;
+    }
+
+    void ReleasePlanner(int key)
+    {
+        auto it = m_Planners.find(key);
+        if (it == m_Planners.end())
+            return;
+
+        m_PlannerPool.push_back(std::move(it->second));
+        m_Planners.erase(it);
+    }
+
+    void MoveBoxTo(size_t index, const Vector3& pos)
+    {
+        if (!MoveAlongPath(index, pos))
+        {
+            m_Boxes.ClearPath(index);
+            m_Boxes.SetTarget(index, pos);
+        }
+    }
+
+    // ACK된 요청까지 버린다. 뒤에 보낸 요청이 남아 있으면 그게 최종 목표라서
+    // (MOVE는 절대 좌표) 예측을 그대로 두고, 없으면 서버 위치가 정답이다.
+    void ReconcileMove(const Protocol::Message& ack)
+    {
+        while (!m_PendingMoves.empty() && int32_t(uint32_t(ack.key) - uint32_t(m_PendingMoves.front().seq)) >= 0)
+            m_PendingMoves.pop_front();
+
+        if (!m_PendingMoves.empty())
+            return;
+
+        const int index = m_Boxes.Find(m_MySessionKey);
+        if (index < 0)
+            return;
+
+        const Vector3 pos((ack.x + 0.5f) * m_CellSize, 0.0f, (ack.z + 0.5f) * m_CellSize);
+        if ((pos - m_OwnGoal).LengthSquared() < 1e-6f)
+            return; // 예측이 맞았다
+
+        // 거절됨 (막힌 셀 등) : 서버 위치로 되돌린다
+        m_OwnGoal = pos;
+        MoveBoxTo(index, pos);
+    }
+
+    // 서버가 준 목표까지 waypoint 경로로 이동. false면 호출 측이 직선 이동
+    bool MoveAlongPath(size_t index, const Vector3& goalPos)
+    {
+        const int key = m_Boxes.Key(index);
+        int sx, sz, gx, gz;
+        if (!m_UsePathfinding || !m_Grid.WorldToGrid(m_Boxes.Target(index), sx, sz) || !m_Grid.WorldToGrid(goalPos, gx, gz))
+        {
+            ReleasePlanner(key);
+            return false;
+        }
+
+        // 시작은 박스가 지금 향하는 셀 (진행 중인 구간은 끝까지 간다)
+        PathPlanner& planner = AcquirePlanner(key);
+        planner.Plan(sx, sz, gx, gz);
+        ApplyPath(planner, index);
+        return true;
+    }
+
+    void ApplyPath(const PathPlanner& planner, size_t index)
+    {
+        const int width = m_Grid.Width();
+
+        m_PathPoints.clear();
+        if (planner.ExtractPath(m_PathCells))
+        {
+            for (int cell : m_PathCells)
+                m_PathPoints.push_back(m_Grid.GridToWorld(cell % width, cell / width));
+        }
+        // 도달 불가면 빈 경로 : 현재 목표 셀에서 멈추고, 장애물이 치워지면 RepairPaths가 다시 뽑는다
+        m_Boxes.SetPath(index, m_PathPoints);
+    }
+
+    // 박스가 다음 셀로 넘어가면 D* Lite 시작점을 옮긴다. 목표에 선 박스의 planner는 반납
+    void UpdatePlanners()
+    {
+        for (auto it = m_Planners.begin(); it != m_Planners.end(); )
+        {
+            const int index = m_Boxes.Find(it->first);
+            int sx, sz;
+            bool done = (index < 0) || !m_Grid.WorldToGrid(m_Boxes.Target(index), sx, sz);
+            if (!done && !m_Boxes.Moving(index) && !m_Boxes.HasPath(index))
+                done = (sx == it->second->GoalX() && sz == it->second->GoalZ());
+
+            if (done)
+            {
+                m_PlannerPool.push_back(std::move(it->second));
+                it = m_Planners.erase(it);
+                continue;
+            }
+
+            it->second->MoveStart(sx, sz);
+            ++it;
+        }
+    }
+
+    // 바뀐 셀을 본 탐색만 고쳐서 경로를 다시 뽑는다
+    void RepairPaths(int gx, int gz)
+    {
+        for (auto& [key, planner] : m_Planners)
+        {
+            if (!planner->NotifyCellChanged(gx, gz))
+                continue;
+
+            const int index = m_Boxes.Find(key);
+            if (index < 0)
+                continue;
+
+            planner->Replan();
+            ApplyPath(*planner, index);
         }
     }
 
@@ -947,45 +1701,72 @@ struct App
     // === Frame ===
     void UpdateAndDraw(float deltaTime)
     {
-        Update(deltaTime);
-        Render();
+        m_Profiler.BeginFrame();
+        if (m_FrameLatency)
+        {
+            // 앞 프레임이 화면에 나갈 때까지 : 여기서 기다리고 Present는 막히지 않는다
+            FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Wait);
+            WaitForSingleObjectEx(m_FrameLatency, 1000, TRUE);
+        }
+        {
+            // 디코드가 끝난 텍스처를 만든다 (로딩이 끝나면 할 일 없음)
+            FrameProfiler::CpuScope scope(m_Profiler, FrameProfiler::CpuPhase::Network);
+            if (m_Assets.Pending())
+                m_Assets.Poll();
+        }
+
+        if (m_SimRate > 0)
+        {
+            InterpolateSim();
+            const SimFrame& sim = m_SimFrames.Front();
+            Render(sim.chunks, sim.obstacleCount);
+        }
+        else
+        {
+            Update(deltaTime, m_Profiler);
+            Render(m_ObstacleChunks, m_ObstacleCount);
+        }
+        m_Profiler.EndFrame(m_Context.Get());
+        UpdateStatsTitle(deltaTime);
     }
 
   
     void SendSpawnRequestToServer(const Vector3& cellCenter)
     {
-        int cellX = static_cast<int>(cellCenter.x / m_CellSize);
-        int cellZ = static_cast<int>(cellCenter.z / m_CellSize);
-
-        std::string msg =
-            "SPAWN " +
-            std::to_string(cellX) + " " +
-            std::to_string(cellZ) + "\n";
+        int cellX = static_cast<int>(floorf(cellCenter.x / m_CellSize));
+        int cellZ = static_cast<int>(floorf(cellCenter.z / m_CellSize));
 
-        m_Client->Send(msg);
+        m_Client->Send(Protocol::Message{ Protocol::Op::Spawn, 0, int16_t(cellX), int16_t(cellZ) });
     }
 
   
     void SendDespawnRequestToServer() const
     {
 
-        std::string msg =
-            "DESPAWN \n";
-
-        m_Client->Send(msg);
+        m_Client->Send(Protocol::Message{ Protocol::Op::Despawn });
     }
 
+    // seq를 붙여 보내고, 응답을 기다리지 않고 내 박스를 바로 움직인다
     void SendMoveRequestToServer(const Vector3& cellCenter)
     {
-        int cellX = static_cast<int>(cellCenter.x / m_CellSize);
-        int cellZ = static_cast<int>(cellCenter.z / m_CellSize);
+        int cellX = static_cast<int>(floorf(cellCenter.x / m_CellSize));
+        int cellZ = static_cast<int>(floorf(cellCenter.z / m_CellSize));
+
+        const int32_t seq = m_NextMoveSeq++;
+        if (m_NextMoveSeq == 0)
+            m_NextMoveSeq = 1;
 
-        std::string msg =
-            "MOVE " +
-            std::to_string(cellX) + " " +
-            std::to_string(cellZ) + "\n";
+        m_Client->Send(Protocol::Message{ Protocol::Op::Move, seq, int16_t(cellX), int16_t(cellZ) });
+        m_PendingMoves.push_back(PendingMove{ seq, int16_t(cellX), int16_t(cellZ) });
+        if (m_PendingMoves.size() > kMaxPendingMoves)
+            m_PendingMoves.pop_front(); // ACK를 안 주는 서버 : 무한히 쌓지 않는다
 
-        m_Client->Send(msg);
+        const int index = m_Boxes.Find(m_MySessionKey);
+        if (index >= 0)
+        {
+            m_OwnGoal = Vector3((cellX + 0.5f) * m_CellSize, 0.0f, (cellZ + 0.5f) * m_CellSize);
+            MoveBoxTo(index, m_OwnGoal);
+        }
     }
 
    
@@ -998,13 +1779,17 @@ struct App
         if (!RayHitGround(ro, rd, hit))
             return;
 
-        Vector3 cellCenter = SnapToCellCenter(hit);
+        const Vector3 cellCenter = SnapToCellCenter(hit);
+        Post([this, cellCenter]() { ClickCell(cellCenter); });
+    }
 
+    // 시뮬레이션 쪽 (Post)
+    void ClickCell(const Vector3& cellCenter)
+    {
         if (m_MySessionKey == -1)
             return; // 아직 ASSIGN 안 받음
 
-        // C++17 호환
-        if (m_Boxes.find(m_MySessionKey) != m_Boxes.end())
+        if (m_Boxes.Find(m_MySessionKey) >= 0)
         {
             SendMoveRequestToServer(cellCenter);
         }
@@ -1022,28 +1807,93 @@ struct App
         Vector3 cellPos = SnapToCellCenter(hit);
 
         int gx, gz;
-        if (!WorldToGrid(cellPos, gx, gz)) return;
+        if (!m_Grid.WorldToGrid(cellPos, gx, gz)) return;
 
-        auto& grid = m_GridFlags;
-        if (grid[gz][gx] == 0)
+        Post([this, gx, gz]() { ToggleObstacle(gx, gz); });
+    }
+
+    // 시뮬레이션 쪽 (Post)
+    void ToggleObstacle(int gx, int gz)
+    {
+        const bool blocked = !m_Grid.IsBlocked(gx, gz);
+        if (m_MySessionKey == -1)
+        {
+            // 서버 없이 혼자 편집
+            SetObstacle(gx, gz, blocked);
+            return;
+        }
+
+        // 장애물은 서버 것 : 요청만 보내고, 돌아온 OBSTACLE_SET/CLEAR로 반영
+        m_Client->Send(Protocol::Message{ blocked ? Protocol::Op::ObstacleSet : Protocol::Op::ObstacleClear,
+            0, int16_t(gx - m_HalfCells), int16_t(gz - m_HalfCells) });
+    }
+
+    // 서버 셀 좌표 -> 그리드. 서버 월드가 더 크면 그리드 밖은 버린다
+    void SetServerObstacle(int cellX, int cellZ, bool blocked)
+    {
+        SetObstacle(cellX + m_HalfCells, cellZ + m_HalfCells, blocked);
+    }
+
+    // 스냅샷 직전 : 장애물과 진행 중인 탐색을 모두 비운다 (O(장애물 수))
+    void ClearObstacles()
+    {
+        for (auto& [key, planner] : m_Planners)
+            m_PlannerPool.push_back(std::move(planner));
+        m_Planners.clear();
+
+        for (ObstacleChunk& chunk : m_ObstacleChunks)
+        {
+            for (int cell : chunk.cells)
+            {
+                m_Grid.SetBlocked(cell % m_Grid.Width(), cell / m_Grid.Width(), false);
+                m_ObstacleSlot[cell] = -1;
+            }
+            chunk.boxes.clear();
+            chunk.cells.clear();
+        }
+        m_ObstacleCount = 0;
+        ++m_ObstacleVersion;
+    }
+
+    // 장애물 추가/제거는 셀 인덱스로 O(1). 그리드 비트, chunk 배열, 경로를 함께 갱신
+    // Returns false if the cell already was in that state.
+    bool SetObstacle(int gx, int gz, bool blocked)
+    {
+        if (!m_Grid.InBounds(gx, gz) || m_Grid.IsBlocked(gx, gz) == blocked)
+            return false;
+
+        const int cell = m_Grid.Index(gx, gz);
+        m_Grid.SetBlocked(gx, gz, blocked);
+        ObstacleChunk& chunk = ChunkOf(gx, gz);
+
+        if (blocked)
         {
             // Add obstacle
-            grid[gz][gx] = 1;
-            Box obstacle; obstacle.Init(cellPos, m_CellSize);
-            m_ObstacleBoxes.push_back(obstacle);
+            m_ObstacleSlot[cell] = int(chunk.boxes.size());
+            chunk.boxes.push_back(m_Grid.GridToWorld(gx, gz));
+            chunk.cells.push_back(cell);
+            ++m_ObstacleCount;
         }
         else
         {
-            // Remove obstacle
-            grid[gz][gx] = 0;
-            m_ObstacleBoxes.erase(
-                std::remove_if(m_ObstacleBoxes.begin(), m_ObstacleBoxes.end(),
-                    [&](const Box& b) {
-                        return (fabs(b.m_Pos.x - cellPos.x) < 1e-3f &&
-                            fabs(b.m_Pos.z - cellPos.z) < 1e-3f);
-                    }),
-                m_ObstacleBoxes.end());
+            // Remove obstacle : 같은 chunk의 마지막 원소를 빈 자리로 옮긴다
+            const int slot = m_ObstacleSlot[cell];
+            const int last = int(chunk.boxes.size()) - 1;
+            if (slot != last)
+            {
+                chunk.boxes[slot] = chunk.boxes[last];
+                chunk.cells[slot] = chunk.cells[last];
+                m_ObstacleSlot[chunk.cells[slot]] = slot;
+            }
+            chunk.boxes.pop_back();
+            chunk.cells.pop_back();
+            m_ObstacleSlot[cell] = -1;
+            --m_ObstacleCount;
         }
+
+        ++m_ObstacleVersion;
+        RepairPaths(gx, gz);
+        return true;
     }
 
     void Resize(UINT w, UINT h)
@@ -1052,7 +1902,7 @@ struct App
         m_Width = w; m_Height = h;
         m_Context->OMSetRenderTargets(0, nullptr, nullptr);
         m_RTV.Reset(); m_DSV.Reset(); m_DSVTex.Reset();
-        m_SwapChain->ResizeBuffers(0, w, h, DXGI_FORMAT_UNKNOWN, 0);
+        m_SwapChain->ResizeBuffers(0, w, h, DXGI_FORMAT_UNKNOWN, m_SwapChainFlags);
         CreateRTVDSV();
         m_Camera.Init((float)w, (float)h);
     }
@@ -1126,6 +1976,59 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         }
         break;
 
+    case WM_KEYDOWN:
+        if (g_App && wParam == VK_F1)
+        {
+            // A* 경로 on/off (다음 MOVE부터 적용)
+            g_App->Post([]() { g_App->m_UsePathfinding = !g_App->m_UsePathfinding; });
+        }
+        else if (g_App && wParam == VK_F2)
+        {
+            // frustum culling on/off (drawn/culled 수는 창 제목)
+            g_App->m_UseCulling = !g_App->m_UseCulling;
+        }
+        else if (g_App && wParam == VK_F3)
+        {
+            // 다른 플레이어 보간 버퍼 on/off
+            g_App->Post([]() { g_App->m_UseInterpolation = !g_App->m_UseInterpolation; });
+        }
+        else if (g_App && wParam == VK_F4)
+        {
+            // 프로파일 요약을 창 제목에 (+ 2초마다 디버그 출력에 percentile 표)
+            g_App->m_ShowProfile = !g_App->m_ShowProfile;
+            g_App->m_StatsTimer = 0.5f;
+            const bool on = g_App->m_ShowProfile;
+            g_App->Post([on]() { g_App->m_SimReport = on; }); // --sim-rate : 스텝 표도
+        }
+        else if (g_App && wParam == VK_F6)
+        {
+            // 지난 FrameProfiler::kFrames 프레임을 CSV로
+            const bool ok = g_App->m_Profiler.WriteCsv(L"frame_profile.csv");
+            OutputDebugString(ok ? L"[Profile] frame_profile.csv written\n" : L"[Profile] frame_profile.csv write failed\n");
+            if (g_App->m_SimRate > 0)
+            {
+                g_App->Post([]()
+                    {
+                        const bool written = g_App->m_SimProfiler.WriteCsv(L"sim_profile.csv");
+                        OutputDebugString(written ? L"[Sim] sim_profile.csv written\n" : L"[Sim] sim_profile.csv write failed\n");
+                    });
+            }
+        }
+#ifdef SHADER_HOT_RELOAD
+        else if (g_App && wParam == VK_F5)
+        {
+            // .hlsl을 고친 뒤 다시 컴파일 (Debug만)
+            g_App->ReloadShaders();
+        }
+#endif
+        else if (g_App && (wParam == VK_OEM_4 || wParam == VK_OEM_6))
+        {
+            // [ / ] : 보간 지연 25ms씩
+            const float step = (wParam == VK_OEM_4) ? -0.025f : 0.025f;
+            g_App->Post([step]() { g_App->m_InterpDelay = std::clamp(g_App->m_InterpDelay + step, 0.0f, 0.5f); });
+        }
+        break;
+
     case WM_DESTROY:
         PostQuitMessage(0);
         break;
@@ -1157,6 +2060,25 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, LPWSTR, int nCmdShow)
 
 
     App app; g_App = &app;
+
+    int argc = 0;
+    if (LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc))
+    {
+        for (int i = 1; i + 1 < argc; ++i)
+        {
+            const std::wstring_view opt = argv[i];
+            if (opt == L"--record")
+                app.m_RecordFile = argv[++i];
+            else if (opt == L"--replay")
+                app.m_ReplayFile = argv[++i];
+            else if (opt == L"--replay-pace")
+                app.m_ReplayPaced = (std::wstring_view(argv[++i]) == L"original");
+            else if (opt == L"--sim-rate")
+                app.m_SimRate = std::clamp(_wtoi(argv[++i]), 0, 1000);
+        }
+        LocalFree(argv);
+    }
+
     if (!app.Init(hWnd)) return -1;
 
     using clock = std::chrono::high_resolution_clock;
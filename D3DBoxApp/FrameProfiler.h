@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <wrl.h>
+#include <d3d11.h>
+
+// =====================================================
+// FrameProfiler : CPU phase timers + GPU timestamp queries, per frame
+//
+// CPU : a CpuScope adds its wall time to one phase of the current frame.
+// GPU : BeginGpu / MarkGpu / EndGpu put a timestamp query at every pass
+// boundary inside one disjoint query. Results are read kGpuLatency frames
+// later without flushing, so the profiler never stalls the pipeline; a
+// frame whose queries are not back by then (or whose disjoint query says
+// the clock changed) simply has no GPU numbers.
+//
+// The last kFrames frames stay in a ring. Report() gives avg / p50 / p95 /
+// p99 per column, WriteCsv() dumps the ring one row per frame.
+// =====================================================
+class FrameProfiler
+{
+public:
+    // 겹치지 않는다 : 합 + 나머지 = 프레임. Wait = waitable swap chain (--sim-rate)
+    enum class CpuPhase : uint8_t { Network, Boxes, Paths, Sky, Grid, Cull, Draw, Present, Wait, Count };
+    // 앞 pass의 끝 ~ 이 pass의 끝
+    enum class GpuPass : uint8_t { Clear, Sky, Grid, Obstacles, Players, Count };
+
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kFrames = 512;
+    static constexpr size_t kCpuPhases = size_t(CpuPhase::Count);
+    static constexpr size_t kGpuPasses = size_t(GpuPass::Count);
+
+    struct Frame
+    {
+        uint64_t index = 0;
+        float frameMs = 0.0f;                    // 지난 BeginFrame부터 (vsync 대기 포함)
+        std::array<float, kCpuPhases> cpuMs{};
+        std::array<float, kGpuPasses> gpuMs{};
+        float gpuTotalMs = 0.0f;
+        bool gpuValid = false;
+    };
+
+    struct Stat { float avg = 0, p50 = 0, p95 = 0, p99 = 0; };
+
+    struct Summary
+    {
+        size_t frames = 0;
+        size_t gpuFrames = 0;
+        Stat frame;
+        std::array<Stat, kCpuPhases> cpu;
+        std::array<Stat, kGpuPasses> gpu;
+        Stat gpuTotal;
+    };
+
+    static const char* CpuPhaseName(CpuPhase p)
+    {
+        static constexpr const char* kNames[] = { "network", "boxes", "paths", "sky", "grid", "cull", "draw", "present", "wait" };
+        return kNames[size_t(p)];
+    }
+
+    static const char* GpuPassName(GpuPass p)
+    {
+        static constexpr const char* kNames[] = { "clear", "sky", "grid", "obstacles", "players" };
+        return kNames[size_t(p)];
+    }
+
+    bool Init(ID3D11Device* device)
+    {
+        D3D11_QUERY_DESC disjoint{ D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+        D3D11_QUERY_DESC stamp{ D3D11_QUERY_TIMESTAMP, 0 };
+        for (auto& q : m_Queries)
+        {
+            if (FAILED(device->CreateQuery(&disjoint, q.disjoint.ReleaseAndGetAddressOf())))
+                return false;
+            for (auto& t : q.stamps)
+            {
+                if (FAILED(device->CreateQuery(&stamp, t.ReleaseAndGetAddressOf())))
+                    return false;
+            }
+        }
+        m_GpuReady = true;
+        return true;
+    }
+
+    // -------------------------
+    // CPU
+    // -------------------------
+    class CpuScope
+    {
+    public:
+        CpuScope(FrameProfiler& p, CpuPhase phase) : m_Profiler(p), m_Phase(phase), m_Start(Clock::now()) {}
+        ~CpuScope() { m_Profiler.m_Current.cpuMs[size_t(m_Phase)] += Ms(Clock::now() - m_Start); }
+
+        CpuScope(const CpuScope&) = delete;
+        CpuScope& operator=(const CpuScope&) = delete;
+
+    private:
+        FrameProfiler& m_Profiler;
+        CpuPhase m_Phase;
+        Clock::time_point m_Start;
+    };
+
+    void BeginFrame()
+    {
+        const auto now = Clock::now();
+        m_Current = {};
+        m_Current.index = m_FrameIndex;
+        m_Current.frameMs = (m_FrameIndex > 0) ? Ms(now - m_FrameStart) : 0.0f;
+        m_FrameStart = now;
+    }
+
+    // 이번 프레임을 ring에 넣고, kGpuLatency 전 프레임의 GPU 결과를 읽는다
+    void EndFrame(ID3D11DeviceContext* context)
+    {
+        m_Ring[m_FrameIndex % kFrames] = m_Current;
+        ++m_FrameIndex;
+        if (m_GpuReady && m_FrameIndex > kGpuLatency)
+            CollectGpu(context, m_FrameIndex - 1 - kGpuLatency);
+    }
+
+    // -------------------------
+    // GPU (Render 안에서)
+    // -------------------------
+    void BeginGpu(ID3D11DeviceContext* context)
+    {
+        if (!m_GpuReady)
+            return;
+        QuerySet& q = m_Queries[m_FrameIndex % kGpuLatencySlots];
+        context->Begin(q.disjoint.Get());
+        context->End(q.stamps[0].Get());
+    }
+
+    void MarkGpu(ID3D11DeviceContext* context, GpuPass pass)
+    {
+        if (m_GpuReady)
+            context->End(m_Queries[m_FrameIndex % kGpuLatencySlots].stamps[size_t(pass) + 1].Get());
+    }
+
+    void EndGpu(ID3D11DeviceContext* context)
+    {
+        if (m_GpuReady)
+            context->End(m_Queries[m_FrameIndex % kGpuLatencySlots].disjoint.Get());
+    }
+
+    // -------------------------
+    // Report
+    // -------------------------
+    Summary Summarize() const
+    {
+        Summary s;
+        const size_t count = (std::min)(size_t(m_FrameIndex), kFrames);
+        s.frames = count;
+
+        std::vector<float> values;
+        values.reserve(count);
+        auto stat = [&](auto&& field, bool gpuOnly)
+            {
+                values.clear();
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const Frame& f = m_Ring[i];
+                    if (!gpuOnly || f.gpuValid)
+                        values.push_back(field(f));
+                }
+                return Compute(values);
+            };
+
+        s.frame = stat([](const Frame& f) { return f.frameMs; }, false);
+        for (size_t p = 0; p < kCpuPhases; ++p)
+            s.cpu[p] = stat([p](const Frame& f) { return f.cpuMs[p]; }, false);
+        for (size_t p = 0; p < kGpuPasses; ++p)
+            s.gpu[p] = stat([p](const Frame& f) { return f.gpuMs[p]; }, true);
+        s.gpuTotal = stat([](const Frame& f) { return f.gpuTotalMs; }, true);
+        s.gpuFrames = values.size();
+        return s;
+    }
+
+    // 여러 줄, 디버그 출력용
+    static void Report(const Summary& s, char* out, size_t size, const char* label = "Profile")
+    {
+        int n = std::snprintf(out, size, "[%s] %zu frames (%zu with GPU)   avg / p50 / p95 / p99 ms\n", label, s.frames, s.gpuFrames);
+        auto line = [&](const char* kind, const char* name, const Stat& st)
+            {
+                if (n >= 0 && size_t(n) < size)
+                    n += std::snprintf(out + n, size - n, "  %-3s %-10s %7.3f %7.3f %7.3f %7.3f\n", kind, name, st.avg, st.p50, st.p95, st.p99);
+            };
+        line("", "frame", s.frame);
+        for (size_t p = 0; p < kCpuPhases; ++p)
+            line("cpu", CpuPhaseName(CpuPhase(p)), s.cpu[p]);
+        for (size_t p = 0; p < kGpuPasses; ++p)
+            line("gpu", GpuPassName(GpuPass(p)), s.gpu[p]);
+        line("gpu", "total", s.gpuTotal);
+    }
+
+    // ring 전체, 오래된 프레임부터. GPU 결과가 없는 칸은 비운다
+    bool WriteCsv(const wchar_t* file) const
+    {
+        FILE* f = nullptr;
+        if (_wfopen_s(&f, file, L"w") != 0 || !f)
+            return false;
+
+        std::fprintf(f, "frame,frame_ms");
+        for (size_t p = 0; p < kCpuPhases; ++p)
+            std::fprintf(f, ",cpu_%s_ms", CpuPhaseName(CpuPhase(p)));
+        for (size_t p = 0; p < kGpuPasses; ++p)
+            std::fprintf(f, ",gpu_%s_ms", GpuPassName(GpuPass(p)));
+        std::fprintf(f, ",gpu_total_ms\n");
+
+        const uint64_t count = (std::min)(m_FrameIndex, uint64_t(kFrames));
+        for (uint64_t i = m_FrameIndex - count; i < m_FrameIndex; ++i)
+        {
+            const Frame& fr = m_Ring[i % kFrames];
+            std::fprintf(f, "%llu,%.4f", (unsigned long long)fr.index, fr.frameMs);
+            for (float ms : fr.cpuMs)
+                std::fprintf(f, ",%.4f", ms);
+            for (float ms : fr.gpuMs)
+                fr.gpuValid ? std::fprintf(f, ",%.4f", ms) : std::fprintf(f, ",");
+            fr.gpuValid ? std::fprintf(f, ",%.4f\n", fr.gpuTotalMs) : std::fprintf(f, ",\n");
+        }
+        std::fclose(f);
+        return true;
+    }
+
+private:
+    static constexpr uint64_t kGpuLatency = 3;               // 이만큼 지난 프레임의 쿼리를 읽는다
+    static constexpr size_t kGpuLatencySlots = kGpuLatency + 1;
+
+    struct QuerySet
+    {
+        Microsoft::WRL::ComPtr<ID3D11Query> disjoint;
+        std::array<Microsoft::WRL::ComPtr<ID3D11Query>, kGpuPasses + 1> stamps; // [0] = 시작
+    };
+
+    static float Ms(Clock::duration d) { return std::chrono::duration<float, std::milli>(d).count(); }
+
+    static Stat Compute(std::vector<float>& v)
+    {
+        Stat s;
+        if (v.empty())
+            return s;
+
+        double sum = 0.0;
+        for (float x : v)
+            sum += x;
+        s.avg = float(sum / v.size());
+
+        std::sort(v.begin(), v.end());
+        auto at = [&v](double q) { return v[(std::min)(v.size() - 1, size_t(q * (v.size() - 1) + 0.5))]; };
+        s.p50 = at(0.50);
+        s.p95 = at(0.95);
+        s.p99 = at(0.99);
+        return s;
+    }
+
+    void CollectGpu(ID3D11DeviceContext* context, uint64_t frame)
+    {
+        QuerySet& q = m_Queries[frame % kGpuLatencySlots];
+        Frame& f = m_Ring[frame % kFrames];
+
+        D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint{};
+        if (context->GetData(q.disjoint.Get(), &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+            disjoint.Disjoint || disjoint.Frequency == 0)
+            return;
+
+        std::array<uint64_t, kGpuPasses + 1> ticks{};
+        for (size_t i = 0; i < ticks.size(); ++i)
+        {
+            if (context->GetData(q.stamps[i].Get(), &ticks[i], sizeof(uint64_t), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+                return;
+        }
+
+        const double toMs = 1000.0 / double(disjoint.Frequency);
+        for (size_t p = 0; p < kGpuPasses; ++p)
+            f.gpuMs[p] = float(double(ticks[p + 1] - ticks[p]) * toMs);
+        f.gpuTotalMs = float(double(ticks[kGpuPasses] - ticks[0]) * toMs);
+        f.gpuValid = true;
+    }
+
+    std::array<Frame, kFrames> m_Ring{};
+    std::array<QuerySet, kGpuLatencySlots> m_Queries;
+    Frame m_Current;
+    uint64_t m_FrameIndex = 0;
+    Clock::time_point m_FrameStart;
+    bool m_GpuReady = false;
+};
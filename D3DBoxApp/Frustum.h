@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <SimpleMath.h>
+
+// =====================================================
+// Frustum : 6 planes taken straight from view * proj (Gribb/Hartmann)
+//
+// Row vectors (clip = v * viewProj) and D3D depth [0, 1]. Plane normals
+// point inward, so a point is inside when dot(n, p) + d >= 0 for all six.
+// AABB test uses the corner furthest along / against each normal.
+// =====================================================
+class Frustum
+{
+public:
+    enum class Result { Outside, Intersect, Inside };
+
+    void Build(const DirectX::SimpleMath::Matrix& vp)
+    {
+        // column j of vp = (_1j, _2j, _3j, _4j)
+        const float c1[4] = { vp._11, vp._21, vp._31, vp._41 };
+        const float c2[4] = { vp._12, vp._22, vp._32, vp._42 };
+        const float c3[4] = { vp._13, vp._23, vp._33, vp._43 };
+        const float c4[4] = { vp._14, vp._24, vp._34, vp._44 };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            m_Planes[0][i] = c4[i] + c1[i]; // left
+            m_Planes[1][i] = c4[i] - c1[i]; // right
+            m_Planes[2][i] = c4[i] + c2[i]; // bottom
+            m_Planes[3][i] = c4[i] - c2[i]; // top
+            m_Planes[4][i] = c3[i];         // near (z >= 0)
+            m_Planes[5][i] = c4[i] - c3[i]; // far
+        }
+    }
+
+    Result Test(const DirectX::SimpleMath::Vector3& mn, const DirectX::SimpleMath::Vector3& mx) const
+    {
+        Result result = Result::Inside;
+        for (const auto& p : m_Planes)
+        {
+            // 법선 쪽으로 가장 먼 꼭짓점이 밖이면 박스 전체가 밖
+            const float outer = p[0] * (p[0] >= 0 ? mx.x : mn.x)
+                + p[1] * (p[1] >= 0 ? mx.y : mn.y)
+                + p[2] * (p[2] >= 0 ? mx.z : mn.z) + p[3];
+            if (outer < 0)
+                return Result::Outside;
+
+            const float inner = p[0] * (p[0] >= 0 ? mn.x : mx.x)
+                + p[1] * (p[1] >= 0 ? mn.y : mx.y)
+                + p[2] * (p[2] >= 0 ? mn.z : mx.z) + p[3];
+            if (inner < 0)
+                result = Result::Intersect;
+        }
+        return result;
+    }
+
+    // XZ bounds of the part of the frustum between heights y0 and y1
+    // (corners inside the slab + the 12 edges cut at y0 / y1).
+    // Returns false if the frustum doesn't reach the slab.
+    static bool FootprintXZ(const DirectX::SimpleMath::Matrix& invViewProj, float y0, float y1,
+        DirectX::SimpleMath::Vector2& mn, DirectX::SimpleMath::Vector2& mx)
+    {
+        using DirectX::SimpleMath::Vector3;
+
+        // corner i : ndc x = bit 0, y = bit 1, z = bit 2
+        Vector3 c[8];
+        for (int i = 0; i < 8; ++i)
+        {
+            const Vector3 ndc((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f);
+            c[i] = Vector3::Transform(ndc, invViewProj);
+        }
+
+        bool any = false;
+        auto add = [&](const Vector3& p)
+            {
+                if (!any)
+                {
+                    mn = mx = { p.x, p.z };
+                    any = true;
+                    return;
+                }
+                mn.x = (std::min)(mn.x, p.x); mn.y = (std::min)(mn.y, p.z);
+                mx.x = (std::max)(mx.x, p.x); mx.y = (std::max)(mx.y, p.z);
+            };
+
+        for (int i = 0; i < 8; ++i)
+        {
+            if (c[i].y >= y0 && c[i].y <= y1)
+                add(c[i]);
+
+            for (int bit = 1; bit < 8; bit <<= 1)
+            {
+                if (i & bit)
+                    continue; // 모서리 (i, i | bit)는 한 번만
+
+                const Vector3& a = c[i];
+                const Vector3& b = c[i | bit];
+                for (float y : { y0, y1 })
+                {
+                    if ((a.y - y) * (b.y - y) < 0.0f)
+                        add(Vector3::Lerp(a, b, (y - a.y) / (b.y - a.y)));
+                }
+            }
+        }
+        return any;
+    }
+
+private:
+    float m_Planes[6][4] = {};
+};
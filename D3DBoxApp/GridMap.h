@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <SimpleMath.h>
+
+// =====================================================
+// GridMap : obstacle occupancy, one bit per cell
+//
+// Row-major (index = gz * width + gx) in one contiguous allocation.
+// Grid (0,0) is the cell at world (-half, -half); cells are m_CellSize wide.
+// 1024x1024 is 128 KB.
+// =====================================================
+class GridMap
+{
+public:
+    // (halfCells * 2 + 1)^2 cells centered on the world origin
+    void Init(int halfCells, float cellSize)
+    {
+        m_HalfCells = halfCells;
+        m_CellSize = cellSize;
+        m_Width = m_Height = halfCells * 2 + 1;
+        m_Bits.assign((size_t(m_Width) * size_t(m_Height) + 63) / 64, 0);
+    }
+
+    int   Width() const { return m_Width; }
+    int   Height() const { return m_Height; }
+    float CellSize() const { return m_CellSize; }
+
+    int  Index(int gx, int gz) const { return gz * m_Width + gx; }
+    bool InBounds(int gx, int gz) const { return gx >= 0 && gz >= 0 && gx < m_Width && gz < m_Height; }
+
+    bool IsBlocked(int gx, int gz) const
+    {
+        const size_t i = size_t(Index(gx, gz));
+        return (m_Bits[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void SetBlocked(int gx, int gz, bool blocked)
+    {
+        const size_t i = size_t(Index(gx, gz));
+        const uint64_t mask = uint64_t(1) << (i & 63);
+        if (blocked)
+            m_Bits[i >> 6] |= mask;
+        else
+            m_Bits[i >> 6] &= ~mask;
+    }
+
+    // Returns the new state.
+    bool Toggle(int gx, int gz)
+    {
+        const size_t i = size_t(Index(gx, gz));
+        m_Bits[i >> 6] ^= uint64_t(1) << (i & 63);
+        return IsBlocked(gx, gz);
+    }
+
+    void Clear() { std::fill(m_Bits.begin(), m_Bits.end(), 0); }
+
+    bool WorldToGrid(const DirectX::SimpleMath::Vector3& pos, int& gx, int& gz) const
+    {
+        const float half = m_HalfCells * m_CellSize;
+        gx = int(floorf((pos.x + half) / m_CellSize));
+        gz = int(floorf((pos.z + half) / m_CellSize));
+        return InBounds(gx, gz);
+    }
+
+    // cell center
+    DirectX::SimpleMath::Vector3 GridToWorld(int gx, int gz) const
+    {
+        const float half = m_HalfCells * m_CellSize;
+        return { -half + (gx + 0.5f) * m_CellSize, 0.0f, -half + (gz + 0.5f) * m_CellSize };
+    }
+
+private:
+    int   m_HalfCells = 0;
+    int   m_Width = 0;
+    int   m_Height = 0;
+    float m_CellSize = 1.0f;
+    std::vector<uint64_t> m_Bits;
+};
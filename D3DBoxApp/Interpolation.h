@@ -0,0 +1,136 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// =====================================================
+// Interpolation buffer for remote entities
+//
+// The server stamps every MOVE batch with its tick (TICK <n> <rate>).
+// ServerClock maps tick time onto the local clock, and each remote box
+// queues its states in a StateBuffer. Every frame the box is placed at
+// the render clock (now - offset - delay) by interpolating between the two
+// states that bracket it, so a burst of packets plays back at the original
+// tick spacing and a move of any length takes exactly its tick interval.
+// =====================================================
+
+// local clock - server tick time, tracked as a running minimum: the least
+// delayed packet is the best estimate, and the slow creep lets it follow
+// when the path really gets slower.
+class ServerClock
+{
+public:
+    void OnTick(uint32_t tick, int rate, double now)
+    {
+        if (rate <= 0)
+            return;
+
+        const double sample = now - double(tick) / rate;
+        m_Offset = m_Valid ? (std::min)(sample, m_Offset + kCreepPerTick) : sample;
+        m_Rate = rate;
+        m_Valid = true;
+    }
+
+    bool   Valid() const { return m_Valid; }
+    int    Rate() const { return m_Rate; }
+    double TickTime(uint32_t tick) const { return double(tick) / m_Rate; }
+
+    // server time to show now
+    double RenderTime(double now, double delay) const { return now - m_Offset - delay; }
+
+    void Reset() { m_Valid = false; }
+
+private:
+    static constexpr double kCreepPerTick = 0.0005;
+
+    double m_Offset = 0.0;
+    int    m_Rate = 0;
+    bool   m_Valid = false;
+};
+
+struct EntityState
+{
+    double time; // server time (s)
+    float  x;    // cellX (셀 중심이 정수, 출발점은 중간일 수도 있다)
+    float  z;    // cellZ
+};
+
+// Per-entity FIFO of timestamped states. MOVE targets absolute cells, so when
+// it overflows the oldest state can simply be dropped.
+// front가 renderTime 이하인 마지막 상태 (구간의 시작), 그다음이 구간의 끝.
+class StateBuffer
+{
+public:
+    static constexpr std::size_t kCapacity = 32;
+
+    void Push(const EntityState& s)
+    {
+        if (m_Count > 0 && Back().time >= s.time)
+        {
+            Back() = s; // 같은 틱. 늦게 온 UDP 배치는 AsyncClient가 SeqNewer로 이미 버렸다
+            return;
+        }
+        if (m_Count == kCapacity)
+            Pop();
+
+        m_States[(m_Head + m_Count) % kCapacity] = s;
+        ++m_Count;
+    }
+
+    // Position at renderTime, interpolated between the bracketing pair.
+    // States older than the pair are dropped; once renderTime passes the
+    // last state the box is left there and the buffer empties, so the next
+    // move starts from wherever the box is (see the caller's seed state).
+    // false if nothing is due yet.
+    bool Sample(double renderTime, float& x, float& z)
+    {
+        while (m_Count >= 2 && At(1).time <= renderTime)
+            Pop();
+        if (m_Count == 0 || At(0).time > renderTime)
+            return false;
+
+        const EntityState& a = At(0);
+        if (m_Count == 1)
+        {
+            x = a.x;
+            z = a.z;
+            Pop();
+            return true;
+        }
+
+        const EntityState& b = At(1); // Push : b.time > a.time
+        const float t = float((renderTime - a.time) / (b.time - a.time));
+        x = a.x + (b.x - a.x) * t;
+        z = a.z + (b.z - a.z) * t;
+        return true;
+    }
+
+    // 보간 off : 남은 것 중 마지막 상태만
+    bool TakeLatest(EntityState& out)
+    {
+        if (m_Count == 0)
+            return false;
+        out = Back();
+        Clear();
+        return true;
+    }
+
+    bool Empty() const { return m_Count == 0; }
+
+    void Clear() { m_Head = m_Count = 0; }
+
+private:
+    EntityState& Back() { return m_States[(m_Head + m_Count - 1) % kCapacity]; }
+    const EntityState& At(std::size_t i) const { return m_States[(m_Head + i) % kCapacity]; }
+
+    void Pop()
+    {
+        m_Head = (m_Head + 1) % kCapacity;
+        --m_Count;
+    }
+
+    std::array<EntityState, kCapacity> m_States{};
+    std::size_t m_Head = 0;
+    std::size_t m_Count = 0;
+};
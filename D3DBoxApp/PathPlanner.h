@@ -0,0 +1,375 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "GridMap.h"
+
+// =====================================================
+// PathPlanner : D* Lite over GridMap
+//
+// 8-connected, integer costs 10/14, no corner cutting. The search runs
+// backward from the goal, so the box moving along its path (MoveStart) and
+// cells toggling (NotifyCellChanged) only repair the part of the search
+// they touch instead of planning from scratch.
+//
+// All per-cell state lives in flat arrays sized once per grid; the open
+// list is an indexed binary heap over those arrays. A new goal bumps a
+// stamp instead of clearing the arrays.
+//
+// Costs are integers on purpose : D* Lite breaks k1 ties with k2, and
+// float sums of sqrt2 along different routes don't tie exactly.
+// =====================================================
+class PathPlanner
+{
+public:
+    static constexpr int kInf = std::numeric_limits<int>::max() / 4;
+
+    void Bind(const GridMap* grid)
+    {
+        m_Grid = grid;
+        m_Width = grid->Width();
+        m_Height = grid->Height();
+
+        const size_t cells = size_t(m_Width) * size_t(m_Height);
+        if (m_Stamp.size() != cells)
+        {
+            m_G.assign(cells, kInf);
+            m_Rhs.assign(cells, kInf);
+            m_Key.assign(cells, Key{});
+            m_HeapPos.assign(cells, -1);
+            m_Stamp.assign(cells, 0);
+            m_Heap.clear();
+            m_Heap.reserve(cells);
+            m_CurStamp = 0;
+        }
+        m_HasGoal = false;
+    }
+
+    bool InBounds(int x, int z) const { return x >= 0 && z >= 0 && x < m_Width && z < m_Height; }
+
+    bool HasGoal() const { return m_HasGoal; }
+    int GoalX() const { return m_Goal % m_Width; }
+    int GoalZ() const { return m_Goal / m_Width; }
+
+    // New search toward (gx,gz). Returns false if the goal is unreachable.
+    bool Plan(int sx, int sz, int gx, int gz)
+    {
+        if (++m_CurStamp == 0) // wrapped : stale stamps could match again
+        {
+            std::fill(m_Stamp.begin(), m_Stamp.end(), 0u);
+            m_CurStamp = 1;
+        }
+        m_Heap.clear();
+
+        m_Km = 0;
+        m_Start = m_Last = Index(sx, sz);
+        m_Goal = Index(gx, gz);
+        m_HasGoal = true;
+
+        Touch(m_Goal);
+        m_Rhs[m_Goal] = 0;
+        HeapPush(m_Goal, Key{ H(m_Start, m_Goal), 0 });
+
+        return ComputeShortestPath();
+    }
+
+    // The box reached a new cell on its path.
+    void MoveStart(int sx, int sz)
+    {
+        const int s = Index(sx, sz);
+        if (s == m_Start)
+            return;
+
+        m_Km = Add(m_Km, H(m_Last, s));
+        m_Last = m_Start = s;
+    }
+
+    // (x,z) toggled in the grid. Returns true if the search saw the change,
+    // i.e. the path has to be repaired with Replan.
+    bool NotifyCellChanged(int x, int z)
+    {
+        if (!m_HasGoal)
+            return false;
+
+        bool changed = false;
+        for (int dz = -1; dz <= 1; ++dz)
+            for (int dx = -1; dx <= 1; ++dx)
+                if (InBounds(x + dx, z + dz))
+                    changed |= UpdateVertex(Index(x + dx, z + dz));
+        return changed;
+    }
+
+    bool Replan() { return m_HasGoal && ComputeShortestPath(); }
+
+    // Cells from the start (exclusive) to the goal (inclusive), as GridMap::Index.
+    bool ExtractPath(std::vector<int>& out) const
+    {
+        out.clear();
+        if (!m_HasGoal || !(Rhs(m_Start) < kInf))
+            return false;
+
+        int cur = m_Start;
+        const size_t limit = m_Stamp.size();
+        while (cur != m_Goal)
+        {
+            int best = -1;
+            int bestCost = kInf;
+            ForEachNeighbor(cur, [&](int v, int c)
+                {
+                    const int total = Add(c, G(v));
+                    if (total < bestCost)
+                    {
+                        bestCost = total;
+                        best = v;
+                    }
+                });
+
+            if (best < 0 || out.size() >= limit)
+                return false;
+
+            out.push_back(best);
+            cur = best;
+        }
+        return true;
+    }
+
+private:
+    struct Key
+    {
+        int k1 = kInf;
+        int k2 = kInf;
+    };
+
+    static int Add(int a, int b) { return (a >= kInf || b >= kInf) ? kInf : (std::min)(a + b, kInf); }
+
+    static bool Less(const Key& a, const Key& b)
+    {
+        return a.k1 < b.k1 || (a.k1 == b.k1 && a.k2 < b.k2);
+    }
+
+    int Index(int x, int z) const { return z * m_Width + x; }
+
+    bool Blocked(int x, int z) const { return m_Grid->IsBlocked(x, z); }
+
+    // octile distance : consistent with the 8-connected costs
+    int H(int a, int b) const
+    {
+        const int dx = std::abs(a % m_Width - b % m_Width);
+        const int dz = std::abs(a / m_Width - b / m_Width);
+        return kStraight * (std::max)(dx, dz) + (kDiagonal - kStraight) * (std::min)(dx, dz);
+    }
+
+    // onNeighbor(int v, int cost) for each passable edge u-v
+    template <typename F>
+    void ForEachNeighbor(int u, F&& onNeighbor) const
+    {
+        const int ux = u % m_Width;
+        const int uz = u / m_Width;
+        if (Blocked(ux, uz))
+            return;
+
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                if (dx == 0 && dz == 0)
+                    continue;
+
+                const int vx = ux + dx;
+                const int vz = uz + dz;
+                if (!InBounds(vx, vz) || Blocked(vx, vz))
+                    continue;
+
+                if (dx != 0 && dz != 0)
+                {
+                    // 대각선은 양옆 두 칸이 모두 비어 있을 때만
+                    if (Blocked(ux + dx, uz) || Blocked(ux, uz + dz))
+                        continue;
+                    onNeighbor(Index(vx, vz), kDiagonal);
+                }
+                else
+                {
+                    onNeighbor(Index(vx, vz), kStraight);
+                }
+            }
+        }
+    }
+
+    // -------------------------
+    // per-cell state (valid only when stamped for the current search)
+    // -------------------------
+    void Touch(int u)
+    {
+        if (m_Stamp[u] == m_CurStamp)
+            return;
+
+        m_Stamp[u] = m_CurStamp;
+        m_G[u] = kInf;
+        m_Rhs[u] = kInf;
+        m_HeapPos[u] = -1;
+    }
+
+    int G(int u) const { return (m_Stamp[u] == m_CurStamp) ? m_G[u] : kInf; }
+    int Rhs(int u) const { return (m_Stamp[u] == m_CurStamp) ? m_Rhs[u] : kInf; }
+
+    Key CalcKey(int u) const
+    {
+        const int m = (std::min)(G(u), Rhs(u));
+        return Key{ Add(Add(m, H(m_Start, u)), m_Km), m };
+    }
+
+    // Returns true if rhs(u) changed.
+    bool UpdateVertex(int u)
+    {
+        Touch(u);
+
+        const int oldRhs = m_Rhs[u];
+        if (u != m_Goal)
+        {
+            int best = kInf;
+            ForEachNeighbor(u, [&](int v, int c) { best = (std::min)(best, Add(c, G(v))); });
+            m_Rhs[u] = best;
+        }
+
+        if (m_G[u] != m_Rhs[u])
+        {
+            if (m_HeapPos[u] >= 0)
+                HeapUpdate(u, CalcKey(u));
+            else
+                HeapPush(u, CalcKey(u));
+        }
+        else if (m_HeapPos[u] >= 0)
+        {
+            HeapRemove(u);
+        }
+        return oldRhs != m_Rhs[u];
+    }
+
+    bool ComputeShortestPath()
+    {
+        while (!m_Heap.empty())
+        {
+            const int u = m_Heap[0];
+            const Key oldKey = m_Key[u];
+            if (!Less(oldKey, CalcKey(m_Start)) && Rhs(m_Start) == G(m_Start))
+                break;
+
+            const Key newKey = CalcKey(u);
+            if (Less(oldKey, newKey))
+            {
+                HeapUpdate(u, newKey);
+            }
+            else if (m_G[u] > m_Rhs[u])
+            {
+                m_G[u] = m_Rhs[u];
+                HeapRemove(u);
+                ForEachNeighbor(u, [this](int v, int) { UpdateVertex(v); });
+            }
+            else
+            {
+                m_G[u] = kInf;
+                UpdateVertex(u);
+                ForEachNeighbor(u, [this](int v, int) { UpdateVertex(v); });
+            }
+        }
+        return Rhs(m_Start) < kInf;
+    }
+
+    // -------------------------
+    // indexed binary heap (min by Key)
+    // -------------------------
+    void HeapPush(int u, const Key& key)
+    {
+        m_Key[u] = key;
+        m_HeapPos[u] = int(m_Heap.size());
+        m_Heap.push_back(u);
+        SiftUp(m_HeapPos[u]);
+    }
+
+    void HeapUpdate(int u, const Key& key)
+    {
+        const bool up = Less(key, m_Key[u]);
+        m_Key[u] = key;
+        if (up)
+            SiftUp(m_HeapPos[u]);
+        else
+            SiftDown(m_HeapPos[u]);
+    }
+
+    void HeapRemove(int u)
+    {
+        const int i = m_HeapPos[u];
+        const int last = m_Heap.back();
+        m_Heap.pop_back();
+        m_HeapPos[u] = -1;
+
+        if (last == u)
+            return;
+
+        m_Heap[i] = last;
+        m_HeapPos[last] = i;
+        SiftUp(i);
+        SiftDown(m_HeapPos[last]);
+    }
+
+    void SiftUp(int i)
+    {
+        const int u = m_Heap[i];
+        while (i > 0)
+        {
+            const int parent = (i - 1) / 2;
+            if (!Less(m_Key[u], m_Key[m_Heap[parent]]))
+                break;
+            m_Heap[i] = m_Heap[parent];
+            m_HeapPos[m_Heap[i]] = i;
+            i = parent;
+        }
+        m_Heap[i] = u;
+        m_HeapPos[u] = i;
+    }
+
+    void SiftDown(int i)
+    {
+        const int n = int(m_Heap.size());
+        const int u = m_Heap[i];
+        for (;;)
+        {
+            int child = i * 2 + 1;
+            if (child >= n)
+                break;
+            if (child + 1 < n && Less(m_Key[m_Heap[child + 1]], m_Key[m_Heap[child]]))
+                ++child;
+            if (!Less(m_Key[m_Heap[child]], m_Key[u]))
+                break;
+            m_Heap[i] = m_Heap[child];
+            m_HeapPos[m_Heap[i]] = i;
+            i = child;
+        }
+        m_Heap[i] = u;
+        m_HeapPos[u] = i;
+    }
+
+private:
+    static constexpr int kStraight = 10;
+    static constexpr int kDiagonal = 14;
+
+    const GridMap* m_Grid = nullptr;
+    int m_Width = 0;
+    int m_Height = 0;
+
+    std::vector<int>      m_G;
+    std::vector<int>      m_Rhs;
+    std::vector<Key>      m_Key;     // heap key, valid while m_HeapPos >= 0
+    std::vector<int>      m_HeapPos; // index in m_Heap, -1 if not open
+    std::vector<uint32_t> m_Stamp;
+    uint32_t              m_CurStamp = 0;
+    std::vector<int>      m_Heap;    // open list
+
+    bool  m_HasGoal = false;
+    int   m_Start = 0;
+    int   m_Last = 0;
+    int   m_Goal = 0;
+    int   m_Km = 0;
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+// =====================================================
+// SpscQueue
+//
+// Lock-free ring for exactly one producer thread and one consumer thread.
+// Producer  : network (io) thread, TryPush
+// Consumer  : render thread, PopAll once per frame
+//
+// Each side owns one index and only reads the other's; the release store
+// on the owned index publishes the slots written/read before it.
+// =====================================================
+template <typename T, std::size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "T is copied slot by slot");
+
+public:
+    // producer only
+    bool TryPush(const T& value)
+    {
+        const std::size_t head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_TailCache == Capacity)
+        {
+            m_TailCache = m_Tail.load(std::memory_order_acquire);
+            if (head - m_TailCache == Capacity)
+                return false;
+        }
+
+        m_Slots[head & (Capacity - 1)] = value;
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // producer only : slots that can be pushed without failing
+    std::size_t FreeCount()
+    {
+        m_TailCache = m_Tail.load(std::memory_order_acquire);
+        return Capacity - (m_Head.load(std::memory_order_relaxed) - m_TailCache);
+    }
+
+    // consumer only : calls onValue(const T&) for everything published so far,
+    // then releases the slots with a single store. Returns the count.
+    template <typename F>
+    std::size_t PopAll(F&& onValue)
+    {
+        const std::size_t tail = m_Tail.load(std::memory_order_relaxed);
+        const std::size_t head = m_Head.load(std::memory_order_acquire);
+
+        for (std::size_t i = tail; i != head; ++i)
+            onValue(m_Slots[i & (Capacity - 1)]);
+
+        m_Tail.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+private:
+    // head/tail on separate cache lines so the two threads don't false share
+    alignas(64) std::atomic<std::size_t> m_Head{ 0 };
+    std::size_t m_TailCache = 0; // producer's last seen m_Tail
+    alignas(64) std::atomic<std::size_t> m_Tail{ 0 };
+    alignas(64) std::array<T, Capacity> m_Slots{};
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// =====================================================
+// TripleBuffer
+//
+// Latest-value handoff from exactly one writer thread to one reader thread.
+// Writer : simulation thread, fills Back() then Publish()
+// Reader : render thread, Acquire() once a frame then reads Front()
+//
+// Three slots : the writer owns one, the reader owns one, the third sits
+// in the middle. Publish and Acquire each swap their own slot with the
+// middle in a single exchange, so neither side ever waits; a frame the
+// reader did not pick up in time is simply overwritten. Slots are reused,
+// so what the writer finds in Back() is an older frame, not an empty one.
+// =====================================================
+template <typename T>
+class TripleBuffer
+{
+public:
+    // 두 스레드가 돌기 전에 : 세 슬롯 모두 (reader가 첫 Publish 전에 볼 Front 포함)
+    template <typename F>
+    void InitSlots(F&& init)
+    {
+        for (T& slot : m_Slots)
+            init(slot);
+    }
+
+    // writer only
+    T& Back() { return m_Slots[m_Back]; }
+
+    void Publish()
+    {
+        const uint8_t prev = m_Middle.exchange(uint8_t(m_Back | kFresh), std::memory_order_acq_rel);
+        m_Back = prev & kIndex;
+    }
+
+    // reader only : true if a newer frame replaced Front()
+    bool Acquire()
+    {
+        if ((m_Middle.load(std::memory_order_relaxed) & kFresh) == 0)
+            return false;
+        const uint8_t prev = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+        m_Front = prev & kIndex;
+        return true;
+    }
+
+    const T& Front() const { return m_Slots[m_Front]; }
+
+private:
+    static constexpr uint8_t kIndex = 3;
+    static constexpr uint8_t kFresh = 4; // middle는 reader가 아직 안 가져간 프레임
+
+    std::array<T, 3> m_Slots{};
+    uint8_t m_Back = 0;                   // writer
+    uint8_t m_Front = 1;                  // reader
+    std::atomic<uint8_t> m_Middle{ 2 };
+};
@@ -0,0 +1,511 @@
+// =====================================================
+// LoadGen : headless load generator for Server
+//
+// Opens --clients connections through AsyncClient (no D3D) from one
+// process. Each one SPAWNs at a random cell and then MOVEs around a small
+// square at --move-rate Hz. Every MOVE carries a seq, so latency is taken
+// twice :
+//   ack  : MOVE -> MOVE_ACK             (handler round trip)
+//   echo : MOVE -> own MOVE in the tick (what the other players see)
+// Prints throughput once a second and p50/p99/p999 at the end.
+// --blip drops each connection now and then (every --blip s on average)
+// to exercise reconnect + RESUME under load.
+//
+// AsyncClient has no strand, so each io_context runs on exactly one
+// thread and the clients are spread over --threads of them. Everything a
+// client touches stays on its own thread; the reporter only reads atomics.
+// =====================================================
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../D3DBoxApp/AsyncClient.h"
+
+using Clock = std::chrono::steady_clock;
+
+std::string g_Host = "172.21.1.35";
+uint16_t    g_Port = 8080;
+int         g_ClientCount = 100;
+int         g_ThreadCount = 0;     // 0 = 코어 수
+double      g_MoveRate = 5.0;      // Hz per client
+int         g_Duration = 10;       // s, 측정 구간
+int         g_Warmup = 2;          // s, 모두 접속한 뒤 측정 전까지
+int         g_ConnectRate = 1000;  // connects/s (SYN 폭주 방지)
+int         g_AreaHalf = 64;       // 스폰 범위 (셀, 중심 ± half)
+int         g_WorldHalf = 512;     // 서버의 --world-half : SPAWN / MOVE가 이 안에 있어야 받아 준다
+int         g_WalkSize = 8;        // MOVE는 한 변 g_WalkSize 셀 정사각형 둘레를 돈다
+bool        g_UseUdp = true;       // 서버가 --udp-port로 열어 두면 MOVE를 UDP로
+bool        g_Reconnect = true;    // 끊기면 다시 붙는다 (서버가 v3면 RESUME)
+double      g_Blip = 0.0;          // s, 클라이언트마다 평균 이 간격으로 연결을 끊는다. 0 = 안 끊는다
+
+std::atomic<bool> g_Measuring{ false };
+
+// =====================================================
+// Per io thread stats : 카운터는 reporter가 읽으므로 atomic, latency는 join 후에만
+// =====================================================
+struct ThreadStats
+{
+    std::atomic<uint64_t> assigned{ 0 };
+    std::atomic<uint64_t> spawned{ 0 };
+    std::atomic<uint64_t> movesSent{ 0 };
+    std::atomic<uint64_t> movesReceived{ 0 }; // 브로드캐스트로 받은 MOVE (fan-out 포함)
+    std::atomic<uint64_t> acks{ 0 };
+    std::atomic<uint64_t> echoes{ 0 };
+    std::atomic<uint64_t> resumed{ 0 };       // RESUME으로 같은 세션을 이어받았다
+
+    std::vector<uint32_t> ackLatency;  // us
+    std::vector<uint32_t> echoLatency; // us
+};
+
+struct Worker
+{
+    boost::asio::io_context io;
+    ThreadStats stats;
+    std::thread thread;
+};
+
+// =====================================================
+// SimClient : io thread only
+// =====================================================
+class SimClient
+{
+public:
+    SimClient(Worker& worker, uint32_t seed)
+        : m_Worker(worker)
+        , m_Timer(worker.io)
+        , m_BlipTimer(worker.io)
+        , m_Rng(seed)
+    {
+        m_Conn = std::make_shared<AsyncClient>(m_Worker.io, g_Host, g_Port,
+            [this](const Protocol::Message& msg) { OnMessage(msg); });
+        m_Conn->UseUdp(g_UseUdp);
+        m_Conn->SetReconnect(g_Reconnect);
+    }
+
+    void Start()
+    {
+        boost::asio::post(m_Worker.io,
+            [this]()
+            {
+                m_Conn->Start();
+                ScheduleBlip();
+            });
+    }
+
+    void Stop()
+    {
+        boost::asio::post(m_Worker.io,
+            [this]()
+            {
+                m_Timer.cancel();
+                m_BlipTimer.cancel();
+            });
+    }
+
+    const AsyncClient& Connection() const { return *m_Conn; }
+
+private:
+    struct SentMove
+    {
+        int32_t seq;
+        int16_t x, z;
+        Clock::time_point time;
+    };
+
+    static constexpr size_t kMaxInFlight = 256;
+
+    void OnMessage(const Protocol::Message& msg)
+    {
+        switch (msg.op)
+        {
+        case Protocol::Op::Assign:
+        {
+            // 다시 붙었는데 새 세션이면 (RESUME이 안 됐다) 처음부터
+            m_Key = msg.key;
+            m_Spawned = false;
+            m_Timer.cancel();
+            m_Worker.stats.assigned.fetch_add(1, std::memory_order_relaxed);
+
+            std::uniform_int_distribution<int> cell(-g_AreaHalf, g_AreaHalf);
+            m_SpawnX = cell(m_Rng);
+            m_SpawnZ = cell(m_Rng);
+            m_Conn->Send(Protocol::Message{ Protocol::Op::Spawn, 0, int16_t(m_SpawnX), int16_t(m_SpawnZ) });
+            break;
+        }
+
+        // 서버가 내 SPAWN을 돌려주면 MOVE 시작 (위상은 랜덤으로 흩는다)
+        case Protocol::Op::Spawn:
+            if (msg.key != m_Key || m_Spawned)
+                break;
+            m_Spawned = true;
+            m_Worker.stats.spawned.fetch_add(1, std::memory_order_relaxed);
+            ScheduleMove(std::uniform_real_distribution<double>(0.0, 1.0)(m_Rng));
+            break;
+
+        // 같은 세션을 이어받았다 : 블록은 서버에 그대로, 끊긴 동안 멈춘 MOVE만 다시 시작
+        case Protocol::Op::Resume:
+            m_Worker.stats.resumed.fetch_add(1, std::memory_order_relaxed);
+            if (m_Spawned)
+                ScheduleMove(std::uniform_real_distribution<double>(0.0, 1.0)(m_Rng));
+            break;
+
+        case Protocol::Op::Move:
+            m_Worker.stats.movesReceived.fetch_add(1, std::memory_order_relaxed);
+            if (msg.key == m_Key)
+                OnEcho(msg);
+            break;
+
+        case Protocol::Op::MoveAck:
+            OnAck(msg);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // 틱 안에서 합쳐진 MOVE는 마지막 것만 온다 : 앞의 것은 버리고 일치하는 것만 잰다
+    // UDP는 한동안 안 바뀐 MOVE를 한 번 더 보낸다 : 방금 잰 셀이면 건너뛴다
+    void OnEcho(const Protocol::Message& msg)
+    {
+        if (msg.x == m_LastEchoX && msg.z == m_LastEchoZ)
+            return;
+        m_LastEchoX = msg.x;
+        m_LastEchoZ = msg.z;
+
+        const auto now = Clock::now();
+        while (!m_AwaitEcho.empty())
+        {
+            const SentMove sent = m_AwaitEcho.front();
+            m_AwaitEcho.pop_front();
+            if (sent.x == msg.x && sent.z == msg.z)
+            {
+                m_Worker.stats.echoes.fetch_add(1, std::memory_order_relaxed);
+                Record(m_Worker.stats.echoLatency, sent.time, now);
+                return;
+            }
+        }
+    }
+
+    // ACK는 보낸 순서대로 온다. UDP로 다시 보낸 MOVE는 ACK가 두 번 올 수 있다
+    void OnAck(const Protocol::Message& msg)
+    {
+        if (!Protocol::SeqNewer(uint32_t(msg.key), uint32_t(m_LastAck)))
+            return;
+        m_LastAck = msg.key;
+
+        const auto now = Clock::now();
+        while (!m_AwaitAck.empty())
+        {
+            const SentMove sent = m_AwaitAck.front();
+            m_AwaitAck.pop_front();
+            if (sent.seq == msg.key)
+            {
+                m_Worker.stats.acks.fetch_add(1, std::memory_order_relaxed);
+                Record(m_Worker.stats.ackLatency, sent.time, now);
+                return;
+            }
+        }
+    }
+
+    static void Record(std::vector<uint32_t>& out, Clock::time_point sent, Clock::time_point now)
+    {
+        if (!g_Measuring.load(std::memory_order_relaxed))
+            return;
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - sent).count();
+        out.push_back(uint32_t(std::min<long long>(us, UINT32_MAX)));
+    }
+
+    void ScheduleMove(double periods)
+    {
+        m_Timer.expires_after(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(periods / g_MoveRate)));
+        m_Timer.async_wait([this](boost::system::error_code ec)
+            {
+                if (ec || !m_Conn->IsOpen())
+                    return;
+                SendMove();
+                ScheduleMove(1.0);
+            });
+    }
+
+    // 끊김 간격은 지수 분포 (평균 g_Blip)
+    void ScheduleBlip()
+    {
+        if (g_Blip <= 0.0)
+            return;
+        m_BlipTimer.expires_after(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(std::exponential_distribution<double>(1.0 / g_Blip)(m_Rng))));
+        m_BlipTimer.async_wait([this](boost::system::error_code ec)
+            {
+                if (ec)
+                    return;
+                m_Conn->Drop();
+                ScheduleBlip();
+            });
+    }
+
+    // 정사각형 둘레의 다음 셀. 앞뒤 목표가 항상 달라서 echo를 셀로 맞출 수 있다
+    void SendMove()
+    {
+        const int side = std::max(1, g_WalkSize);
+        const int i = m_Step++ % (side * 4);
+        int dx = 0, dz = 0;
+        if (i < side)          { dx = i;                dz = 0; }
+        else if (i < side * 2) { dx = side;             dz = i - side; }
+        else if (i < side * 3) { dx = side * 3 - i;     dz = side; }
+        else                   { dx = 0;                dz = side * 4 - i; }
+
+        const SentMove move{ m_NextSeq++, int16_t(m_SpawnX + dx), int16_t(m_SpawnZ + dz), Clock::now() };
+        if (m_NextSeq == 0)
+            m_NextSeq = 1;
+
+        m_Conn->Send(Protocol::Message{ Protocol::Op::Move, move.seq, move.x, move.z });
+        m_Worker.stats.movesSent.fetch_add(1, std::memory_order_relaxed);
+
+        m_AwaitAck.push_back(move);
+        m_AwaitEcho.push_back(move);
+        if (m_AwaitAck.size() > kMaxInFlight)
+            m_AwaitAck.pop_front();
+        if (m_AwaitEcho.size() > kMaxInFlight)
+            m_AwaitEcho.pop_front();
+    }
+
+    Worker& m_Worker;
+    std::shared_ptr<AsyncClient> m_Conn;
+    boost::asio::steady_timer m_Timer;
+    boost::asio::steady_timer m_BlipTimer;
+    std::mt19937 m_Rng;
+
+    int     m_Key = -1;
+    bool    m_Spawned = false;
+    int     m_SpawnX = 0, m_SpawnZ = 0;
+    int     m_Step = 1; // 0은 스폰 셀
+    int32_t m_NextSeq = 1;
+    int32_t m_LastAck = 0;
+    int     m_LastEchoX = INT32_MIN, m_LastEchoZ = INT32_MIN;
+    std::deque<SentMove> m_AwaitAck;
+    std::deque<SentMove> m_AwaitEcho;
+};
+
+// =====================================================
+// Report
+// =====================================================
+struct Totals
+{
+    uint64_t assigned = 0, spawned = 0, open = 0, udp = 0;
+    uint64_t movesSent = 0, movesReceived = 0, acks = 0, echoes = 0;
+    uint64_t bytesIn = 0, bytesOut = 0;
+    uint64_t reconnects = 0, resumed = 0;
+};
+
+Totals Collect(const std::vector<std::unique_ptr<Worker>>& workers,
+    const std::vector<std::unique_ptr<SimClient>>& clients)
+{
+    Totals t;
+    for (const auto& w : workers)
+    {
+        t.assigned += w->stats.assigned.load(std::memory_order_relaxed);
+        t.spawned += w->stats.spawned.load(std::memory_order_relaxed);
+        t.movesSent += w->stats.movesSent.load(std::memory_order_relaxed);
+        t.movesReceived += w->stats.movesReceived.load(std::memory_order_relaxed);
+        t.acks += w->stats.acks.load(std::memory_order_relaxed);
+        t.echoes += w->stats.echoes.load(std::memory_order_relaxed);
+        t.resumed += w->stats.resumed.load(std::memory_order_relaxed);
+    }
+    for (const auto& c : clients)
+    {
+        t.open += c->Connection().IsOpen() ? 1 : 0;
+        t.udp += c->Connection().UdpUp() ? 1 : 0;
+        t.bytesIn += c->Connection().BytesReceived();
+        t.bytesOut += c->Connection().BytesSent();
+        t.reconnects += c->Connection().Reconnects();
+    }
+    return t;
+}
+
+void PrintRate(const char* label, const Totals& a, const Totals& b, double seconds)
+{
+    char line[256];
+    std::snprintf(line, sizeof(line),
+        "%s open %llu (udp %llu) spawned %llu | move out %.0f/s in %.0f/s | ack %.0f/s echo %.0f/s | %.2f MB/s in %.2f MB/s out\n",
+        label,
+        (unsigned long long)b.open, (unsigned long long)b.udp, (unsigned long long)b.spawned,
+        (b.movesSent - a.movesSent) / seconds, (b.movesReceived - a.movesReceived) / seconds,
+        (b.acks - a.acks) / seconds, (b.echoes - a.echoes) / seconds,
+        (b.bytesIn - a.bytesIn) / seconds / 1e6, (b.bytesOut - a.bytesOut) / seconds / 1e6);
+    std::cout << line;
+}
+
+void PrintLatency(const char* label, std::vector<uint32_t>& us)
+{
+    if (us.empty())
+    {
+        std::cout << label << " : no samples\n";
+        return;
+    }
+
+    auto at = [&us](double q)
+        {
+            const size_t i = std::min(us.size() - 1, size_t(q * double(us.size())));
+            std::nth_element(us.begin(), us.begin() + i, us.end());
+            return us[i] / 1000.0;
+        };
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "%s : n %zu  p50 %.2f ms  p99 %.2f ms  p999 %.2f ms  max %.2f ms\n",
+        label, us.size(), at(0.50), at(0.99), at(0.999), *std::max_element(us.begin(), us.end()) / 1000.0);
+    std::cout << line;
+}
+
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string opt = argv[i];
+        if (opt == "--host")
+            g_Host = argv[i + 1];
+        else if (opt == "--port")
+            g_Port = uint16_t(std::atoi(argv[i + 1]));
+        else if (opt == "--clients")
+            g_ClientCount = std::max(1, std::atoi(argv[i + 1]));
+        else if (opt == "--threads")
+            g_ThreadCount = std::atoi(argv[i + 1]);
+        else if (opt == "--move-rate")
+            g_MoveRate = std::max(0.01, std::atof(argv[i + 1]));
+        else if (opt == "--duration")
+            g_Duration = std::max(1, std::atoi(argv[i + 1]));
+        else if (opt == "--warmup")
+            g_Warmup = std::max(0, std::atoi(argv[i + 1]));
+        else if (opt == "--connect-rate")
+            g_ConnectRate = std::max(1, std::atoi(argv[i + 1]));
+        else if (opt == "--area")
+            g_AreaHalf = std::max(0, std::atoi(argv[i + 1]));
+        else if (opt == "--world-half")
+            g_WorldHalf = std::clamp(std::atoi(argv[i + 1]), 1, Protocol::kMaxObstacleHalf);
+        else if (opt == "--walk")
+            g_WalkSize = std::clamp(std::atoi(argv[i + 1]), 1, 1000);
+        else if (opt == "--udp")
+            g_UseUdp = std::atoi(argv[i + 1]) != 0;
+        else if (opt == "--reconnect")
+            g_Reconnect = std::atoi(argv[i + 1]) != 0;
+        else if (opt == "--blip")
+            g_Blip = std::max(0.0, std::atof(argv[i + 1]));
+    }
+
+    if (g_ThreadCount <= 0)
+        g_ThreadCount = std::max(1, int(std::thread::hardware_concurrency()));
+
+    // 스폰 + 둘레(+x, +z로 walk칸)가 월드 밖이면 서버가 말없이 버린다 : 그 클라이언트는 끝까지 논다
+    g_WalkSize = std::min(g_WalkSize, g_WorldHalf);
+    if (g_AreaHalf + g_WalkSize > g_WorldHalf)
+    {
+        const int area = g_WorldHalf - g_WalkSize;
+        std::cout << "--area " << g_AreaHalf << " + --walk " << g_WalkSize << " exceeds --world-half " << g_WorldHalf
+            << " : using --area " << area << "\n";
+        g_AreaHalf = area;
+    }
+
+    std::cout << "LoadGen " << g_ClientCount << " clients -> " << g_Host << ":" << g_Port
+        << " (" << g_ThreadCount << " threads, MOVE " << g_MoveRate << " Hz)\n";
+
+    try
+    {
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (int i = 0; i < g_ThreadCount; ++i)
+            workers.push_back(std::make_unique<Worker>());
+
+        std::vector<std::unique_ptr<SimClient>> clients;
+        clients.reserve(g_ClientCount);
+        for (int i = 0; i < g_ClientCount; ++i)
+            clients.push_back(std::make_unique<SimClient>(*workers[i % g_ThreadCount], uint32_t(i) * 2654435761u + 1));
+
+        // 타이머가 없을 때도 run이 바로 끝나지 않게
+        std::vector<boost::asio::executor_work_guard<boost::asio::io_context::executor_type>> guards;
+        for (auto& w : workers)
+        {
+            guards.push_back(boost::asio::make_work_guard(w->io));
+            w->thread = std::thread([&io = w->io]() { io.run(); });
+        }
+
+        // 접속은 g_ConnectRate로 나눠서
+        const auto connectStart = Clock::now();
+        for (int i = 0; i < g_ClientCount; ++i)
+        {
+            clients[i]->Start();
+            std::this_thread::sleep_until(connectStart + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(double(i + 1) / g_ConnectRate)));
+        }
+
+        Totals prev = Collect(workers, clients);
+        auto prevTime = Clock::now();
+        auto report = [&](const char* label)
+            {
+                std::this_thread::sleep_until(prevTime + std::chrono::seconds(1));
+                const Totals cur = Collect(workers, clients);
+                const auto now = Clock::now();
+                PrintRate(label, prev, cur, std::chrono::duration<double>(now - prevTime).count());
+                prev = cur;
+                prevTime = now;
+            };
+
+        for (int s = 0; s < g_Warmup; ++s)
+            report("warmup ");
+
+        g_Measuring.store(true);
+        const Totals first = prev;
+        const auto measureStart = prevTime;
+        for (int s = 0; s < g_Duration; ++s)
+            report("measure");
+        g_Measuring.store(false);
+
+        const Totals last = prev;
+        const double seconds = std::chrono::duration<double>(prevTime - measureStart).count();
+
+        for (auto& c : clients)
+            c->Stop();
+        guards.clear();
+        for (auto& w : workers)
+            w->io.stop();
+        for (auto& w : workers)
+            w->thread.join();
+
+        // 결과
+        std::vector<uint32_t> ack, echo;
+        for (auto& w : workers)
+        {
+            ack.insert(ack.end(), w->stats.ackLatency.begin(), w->stats.ackLatency.end());
+            echo.insert(echo.end(), w->stats.echoLatency.begin(), w->stats.echoLatency.end());
+        }
+
+        std::cout << "---- " << g_ClientCount << " clients, " << seconds << " s measured, "
+            << last.assigned << " assigned, " << last.spawned << " spawned, "
+            << last.reconnects << " reconnects, " << last.resumed << " resumed\n";
+        if (last.spawned < last.assigned)
+        {
+            std::cout << "WARNING " << (last.assigned - last.spawned) << " sessions never got their SPAWN back"
+                << " (rejected by the server, or dropped first) : they sent no MOVE\n";
+        }
+        PrintRate("total  ", first, last, seconds);
+        PrintLatency("MOVE -> MOVE_ACK ", ack);
+        PrintLatency("MOVE -> echo     ", echo);
+
+        // 소켓/타이머는 io_context보다 먼저 정리
+        clients.clear();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "LoadGen exception: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
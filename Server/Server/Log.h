@@ -0,0 +1,375 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// =====================================================
+// Logger : asynchronous, rate-limited
+//
+// Callers (any io thread) format into a slot of a bounded lock-free ring
+// and return; one background thread drains the ring to stdout. Nothing on
+// the hot path touches the console or takes a lock.
+//
+// Before anything is formatted a line has to pass, in order :
+//   level    : --log-level (debug | info | warn | error | off)
+//   sampling : 1 in N per category (--log-sample move=10)
+//   rate     : lines per second per category (--log-rate move=100, 0 = none)
+// Lines refused by sampling are simply not written; lines refused by the
+// rate limit or a full ring are counted and reported once a second, so a
+// flood shows up as one summary line instead of stalling the server.
+//
+// The ring is Vyukov's bounded queue : every cell carries a sequence
+// number, producers claim a position with one CAS and publish the cell by
+// storing pos + 1, the consumer frees it by storing pos + capacity.
+// =====================================================
+enum class LogLevel : uint8_t { Debug, Info, Warn, Error, Off };
+
+enum class LogCategory : uint8_t
+{
+    Server,
+    Net,          // CONNECT / DISCONNECT
+    Protocol,
+    Spawn,
+    Move,
+    Despawn,
+    Obstacle,
+    Backpressure,
+    Count
+};
+
+class Logger
+{
+public:
+    static constexpr size_t kCapacity = 8192; // records, power of two
+    static constexpr size_t kTextSize = 112;
+
+    Logger()
+        : m_Cells(std::make_unique<Cell[]>(kCapacity))
+        , m_Start(std::chrono::steady_clock::now())
+    {
+        for (size_t i = 0; i < kCapacity; ++i)
+            m_Cells[i].seq.store(i, std::memory_order_relaxed);
+
+        for (auto& c : m_Categories)
+            c.rate = kDefaultRate;
+        m_Categories[size_t(LogCategory::Move)].rate = kDefaultMoveRate;
+    }
+
+    ~Logger() { Stop(); }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    // -------------------------
+    // config (before Start)
+    // -------------------------
+    void SetLevel(LogLevel level) { m_Level = level; }
+
+    // "debug" | "info" | "warn" | "error" | "off"
+    bool SetLevel(std::string_view name)
+    {
+        static constexpr const char* kNames[] = { "debug", "info", "warn", "error", "off" };
+        for (size_t i = 0; i < std::size(kNames); ++i)
+        {
+            if (name == kNames[i])
+            {
+                m_Level = LogLevel(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // "<category>=<lines per second>", "all=" for every category
+    bool SetRate(std::string_view spec) { return Configure(spec, false); }
+
+    // "<category>=<N>" : 1 in N lines
+    bool SetSample(std::string_view spec) { return Configure(spec, true); }
+
+    // -------------------------
+    // drain thread
+    // -------------------------
+    void Start()
+    {
+        if (m_Thread.joinable())
+            return;
+        m_Running.store(true, std::memory_order_relaxed);
+        m_Thread = std::thread([this]() { Run(); });
+    }
+
+    // Writes out everything that is already in the ring.
+    void Stop()
+    {
+        if (!m_Thread.joinable())
+            return;
+        m_Running.store(false, std::memory_order_relaxed);
+        m_Thread.join();
+    }
+
+    // -------------------------
+    // producers (any thread)
+    // -------------------------
+    template <typename... Args>
+    void Write(LogLevel level, LogCategory category, const char* fmt, Args... args)
+    {
+        if (!Admit(level, category))
+            return;
+
+        size_t pos;
+        Cell* cell = Claim(pos);
+        if (!cell)
+        {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        Record& r = cell->record;
+        r.time = std::chrono::steady_clock::now() - m_Start;
+        r.level = level;
+        r.category = category;
+        if constexpr (sizeof...(Args) == 0)
+        {
+            const size_t n = (std::min)(std::strlen(fmt), kTextSize - 1);
+            std::memcpy(r.text, fmt, n);
+            r.text[n] = '\0';
+        }
+        else
+        {
+            std::snprintf(r.text, kTextSize, fmt, args...);
+        }
+
+        cell->seq.store(pos + 1, std::memory_order_release);
+    }
+
+    template <typename... Args> void Debug(LogCategory c, const char* fmt, Args... args) { Write(LogLevel::Debug, c, fmt, args...); }
+    template <typename... Args> void Info(LogCategory c, const char* fmt, Args... args) { Write(LogLevel::Info, c, fmt, args...); }
+    template <typename... Args> void Warn(LogCategory c, const char* fmt, Args... args) { Write(LogLevel::Warn, c, fmt, args...); }
+    template <typename... Args> void Error(LogCategory c, const char* fmt, Args... args) { Write(LogLevel::Error, c, fmt, args...); }
+
+private:
+    static constexpr uint32_t kDefaultRate = 1000;    // lines/s
+    static constexpr uint32_t kDefaultMoveRate = 100; // MOVE는 세션 수 x 클릭 속도로 늘어난다
+
+    static constexpr const char* kCategoryNames[] = {
+        "SERVER", "NET", "PROTOCOL", "SPAWN", "MOVE", "DESPAWN", "OBSTACLE", "BACKPRESSURE"
+    };
+    static_assert(std::size(kCategoryNames) == size_t(LogCategory::Count));
+
+    struct Record
+    {
+        std::chrono::steady_clock::duration time;
+        LogLevel    level;
+        LogCategory category;
+        char        text[kTextSize];
+    };
+
+    struct Cell
+    {
+        std::atomic<size_t> seq;
+        Record record;
+    };
+
+    struct Category
+    {
+        uint32_t rate = 0;   // lines/s, 0 = unlimited
+        uint32_t sample = 1; // 1 in N
+
+        std::atomic<uint64_t> sampleCounter{ 0 };
+        std::atomic<int64_t>  window{ -1 };       // 지금 세는 초
+        std::atomic<uint32_t> windowCount{ 0 };
+        std::atomic<uint64_t> suppressed{ 0 };    // rate limit에 걸린 줄 (drain이 보고하고 0으로)
+    };
+
+    bool Configure(std::string_view spec, bool sample)
+    {
+        const size_t eq = spec.find('=');
+        if (eq == std::string_view::npos)
+            return false;
+
+        const std::string_view name = spec.substr(0, eq);
+        const long value = std::strtol(std::string(spec.substr(eq + 1)).c_str(), nullptr, 10);
+        if (value < 0)
+            return false;
+
+        bool found = false;
+        for (size_t i = 0; i < size_t(LogCategory::Count); ++i)
+        {
+            if (name != "all" && !EqualsIgnoreCase(name, kCategoryNames[i]))
+                continue;
+            if (sample)
+                m_Categories[i].sample = uint32_t((std::max)(1L, value));
+            else
+                m_Categories[i].rate = uint32_t(value);
+            found = true;
+        }
+        return found;
+    }
+
+    static bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+            [](char x, char y) { return std::tolower(uint8_t(x)) == std::tolower(uint8_t(y)); });
+    }
+
+    bool Admit(LogLevel level, LogCategory category)
+    {
+        if (level < m_Level || m_Level == LogLevel::Off)
+            return false;
+
+        Category& c = m_Categories[size_t(category)];
+        if (c.sample > 1 && c.sampleCounter.fetch_add(1, std::memory_order_relaxed) % c.sample != 0)
+            return false;
+
+        if (c.rate == 0 || level >= LogLevel::Error)
+            return true;
+
+        // 1초 고정 창. 창이 바뀌는 순간의 경합은 몇 줄 오차일 뿐이다
+        const int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - m_Start).count();
+        int64_t window = c.window.load(std::memory_order_relaxed);
+        if (window != second && c.window.compare_exchange_strong(window, second, std::memory_order_relaxed))
+            c.windowCount.store(0, std::memory_order_relaxed);
+
+        if (c.windowCount.fetch_add(1, std::memory_order_relaxed) < c.rate)
+            return true;
+
+        c.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // nullptr if the ring is full
+    Cell* Claim(size_t& pos)
+    {
+        pos = m_Enqueue.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Cell* cell = &m_Cells[pos & (kCapacity - 1)];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const intptr_t diff = intptr_t(seq) - intptr_t(pos);
+            if (diff == 0)
+            {
+                if (m_Enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return cell;
+            }
+            else if (diff < 0)
+            {
+                return nullptr;
+            }
+            else
+            {
+                pos = m_Enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // consumer only. Appends ready records to out, up to limit bytes.
+    size_t Drain(std::string& out, size_t limit)
+    {
+        static constexpr const char* kLevelNames[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+        size_t count = 0;
+        while (out.size() < limit)
+        {
+            Cell& cell = m_Cells[m_Dequeue & (kCapacity - 1)];
+            if (cell.seq.load(std::memory_order_acquire) != m_Dequeue + 1)
+                break; // 비었거나 아직 쓰는 중
+
+            const Record& r = cell.record;
+            char line[kTextSize + 64];
+            const int n = std::snprintf(line, sizeof(line), "%10.3f %s [%s] %s\n",
+                std::chrono::duration<double>(r.time).count(),
+                kLevelNames[size_t(r.level)], kCategoryNames[size_t(r.category)], r.text);
+            out.append(line, (std::min)(size_t((std::max)(n, 0)), sizeof(line) - 1));
+
+            cell.seq.store(m_Dequeue + kCapacity, std::memory_order_release);
+            ++m_Dequeue;
+            ++count;
+        }
+        return count;
+    }
+
+    void ReportSuppressed(std::string& out)
+    {
+        char line[128];
+        for (size_t i = 0; i < size_t(LogCategory::Count); ++i)
+        {
+            const uint64_t n = m_Categories[i].suppressed.exchange(0, std::memory_order_relaxed);
+            if (n > 0)
+            {
+                std::snprintf(line, sizeof(line), "%10.3f INFO  [LOG] %llu %s lines over the rate limit\n",
+                    Elapsed(), (unsigned long long)n, kCategoryNames[i]);
+                out += line;
+            }
+        }
+
+        const uint64_t dropped = m_Dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            std::snprintf(line, sizeof(line), "%10.3f WARN  [LOG] %llu lines dropped (ring full)\n",
+                Elapsed(), (unsigned long long)dropped);
+            out += line;
+        }
+    }
+
+    double Elapsed() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+    }
+
+    void Run()
+    {
+        std::string out;
+        out.reserve(kFlushBytes + kTextSize + 64);
+        auto nextReport = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+        for (;;)
+        {
+            const bool running = m_Running.load(std::memory_order_relaxed);
+            const size_t count = Drain(out, kFlushBytes);
+
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= nextReport || !running)
+            {
+                ReportSuppressed(out);
+                nextReport = now + std::chrono::seconds(1);
+            }
+
+            if (!out.empty())
+            {
+                std::fwrite(out.data(), 1, out.size(), stdout);
+                std::fflush(stdout);
+                out.clear();
+            }
+
+            if (!running && count == 0)
+                break;
+            if (count == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+
+    static constexpr size_t kFlushBytes = 64 * 1024;
+
+    std::unique_ptr<Cell[]> m_Cells;
+    alignas(64) std::atomic<size_t> m_Enqueue{ 0 };
+    alignas(64) size_t m_Dequeue = 0; // drain thread only
+
+    std::array<Category, size_t(LogCategory::Count)> m_Categories;
+    LogLevel m_Level = LogLevel::Info;
+    std::atomic<uint64_t> m_Dropped{ 0 };
+
+    std::chrono::steady_clock::time_point m_Start;
+    std::atomic<bool> m_Running{ false };
+    std::thread m_Thread;
+};
@@ -0,0 +1,269 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../../Shared/Protocol.h"
+
+// =====================================================
+// Metrics : per-thread counters and histograms
+//
+// Every thread that records gets its own ThreadMetrics block (registered
+// once, on first use). Only that thread writes to it, so an update is a
+// relaxed load + store on a cache line nobody else writes : no lock, no
+// contended RMW. A scrape sums the blocks; values may be a few updates
+// behind, which is fine for rates.
+//
+// Render writes what is here in the Prometheus text format (0.0.4). The
+// server adds its gauges (sessions, write queues) and serves it over HTTP.
+// =====================================================
+namespace Metrics
+{
+    constexpr size_t kOpSlots = 16;
+    static_assert(size_t(Protocol::Op::ResumeToken) < kOpSlots, "grow kOpSlots with Protocol::Op");
+
+    enum class Fanout : uint8_t
+    {
+        Broadcast, // BroadcastEncoded : every joined session (obstacle edits)
+        Tick,      // TickLoop::Tick : collect dirty blocks + AOI filter + per-session batches
+        Count
+    };
+
+    inline const char* FanoutName(Fanout f) { return (f == Fanout::Broadcast) ? "broadcast" : "tick"; }
+
+    // upper bounds in seconds (le). Command handling is microseconds, a tick can be milliseconds
+    constexpr std::array<double, 16> kBuckets = {
+        1e-6, 2.5e-6, 5e-6, 10e-6, 25e-6, 50e-6, 100e-6, 250e-6,
+        500e-6, 1e-3, 2.5e-3, 5e-3, 10e-3, 25e-3, 50e-3, 100e-3
+    };
+
+    // single writer : the owning thread
+    inline void Add(std::atomic<uint64_t>& c, uint64_t n)
+    {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    struct Histogram
+    {
+        std::array<std::atomic<uint64_t>, kBuckets.size() + 1> buckets{}; // 마지막 = +Inf
+        std::atomic<uint64_t> count{ 0 };
+        std::atomic<uint64_t> sumNs{ 0 };
+
+        void Observe(std::chrono::steady_clock::duration d)
+        {
+            const double seconds = std::chrono::duration<double>(d).count();
+            size_t i = 0;
+            while (i < kBuckets.size() && seconds > kBuckets[i])
+                ++i;
+            Add(buckets[i], 1);
+            Add(count, 1);
+            Add(sumNs, uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+        }
+    };
+
+    struct alignas(64) ThreadMetrics
+    {
+        std::array<std::atomic<uint64_t>, kOpSlots> received{}; // HandleCommand에 들어온 메시지, op별
+        std::array<Histogram, kOpSlots> handle;                 // HandleCommand 시간, op별
+        std::array<Histogram, size_t(Fanout::Count)> fanout;
+
+        std::atomic<uint64_t> bytesReceived{ 0 };
+        std::atomic<uint64_t> bytesSent{ 0 };
+        std::atomic<uint64_t> movesDelivered{ 0 };  // 세션별 배치에 들어간 MOVE (fan-out 후)
+        std::atomic<uint64_t> slowConsumerDrops{ 0 };
+
+        std::atomic<uint64_t> udpReceived{ 0 };
+        std::atomic<uint64_t> udpSent{ 0 };
+        std::atomic<uint64_t> udpRejected{ 0 };     // 모르는 토큰, 늦게 온 seq
+
+        std::atomic<uint64_t> resumeDelta{ 0 };     // RESUME : 바뀐 것만 보냈다
+        std::atomic<uint64_t> resumeSnapshot{ 0 };  // RESUME : 기록이 모자라 전체 스냅샷
+        std::atomic<uint64_t> resumeRejected{ 0 };  // RESUME : 모르는 세션 / 토큰 / 창이 지났다 -> 새 세션
+    };
+
+    class Registry
+    {
+    public:
+        ThreadMetrics& Local()
+        {
+            thread_local ThreadMetrics* t_Local = nullptr;
+            if (!t_Local)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Threads.push_back(std::make_unique<ThreadMetrics>());
+                t_Local = m_Threads.back().get();
+            }
+            return *t_Local;
+        }
+
+        // Sums every thread's block. Appends to out.
+        void Render(std::string& out)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            auto sum = [this](auto&& field)
+                {
+                    uint64_t total = 0;
+                    for (auto& t : m_Threads)
+                        total += field(*t).load(std::memory_order_relaxed);
+                    return total;
+                };
+
+            Header(out, "netbox_messages_received_total", "counter", "Client messages handled, by opcode");
+            for (size_t op = 0; op < kOpSlots; ++op)
+            {
+                const char* name = Protocol::OpName(Protocol::Op(op));
+                if (*name == '\0')
+                    continue;
+                Sample(out, "netbox_messages_received_total", "op", name,
+                    double(sum([op](ThreadMetrics& t) -> auto& { return t.received[op]; })));
+            }
+
+            Header(out, "netbox_handle_command_seconds", "histogram", "Session::HandleCommand latency, by opcode");
+            for (size_t op = 0; op < kOpSlots; ++op)
+            {
+                const char* name = Protocol::OpName(Protocol::Op(op));
+                if (*name == '\0')
+                    continue;
+                RenderHistogram(out, "netbox_handle_command_seconds", "op", name,
+                    [op](ThreadMetrics& t) -> Histogram& { return t.handle[op]; });
+            }
+
+            Header(out, "netbox_fanout_seconds", "histogram", "Time to fan one broadcast / one tick out to the sessions");
+            for (size_t f = 0; f < size_t(Fanout::Count); ++f)
+            {
+                RenderHistogram(out, "netbox_fanout_seconds", "kind", FanoutName(Fanout(f)),
+                    [f](ThreadMetrics& t) -> Histogram& { return t.fanout[f]; });
+            }
+
+            Header(out, "netbox_bytes_received_total", "counter", "Bytes read from client sockets");
+            Sample(out, "netbox_bytes_received_total", nullptr, nullptr,
+                double(sum([](ThreadMetrics& t) -> auto& { return t.bytesReceived; })));
+
+            Header(out, "netbox_bytes_sent_total", "counter", "Bytes written to client sockets");
+            Sample(out, "netbox_bytes_sent_total", nullptr, nullptr,
+                double(sum([](ThreadMetrics& t) -> auto& { return t.bytesSent; })));
+
+            Header(out, "netbox_moves_delivered_total", "counter", "MOVEs put into per-session tick batches (after AOI fan-out)");
+            Sample(out, "netbox_moves_delivered_total", nullptr, nullptr,
+                double(sum([](ThreadMetrics& t) -> auto& { return t.movesDelivered; })));
+
+            Header(out, "netbox_slow_consumer_drops_total", "counter", "Sessions closed for exceeding --write-queue-limit");
+            Sample(out, "netbox_slow_consumer_drops_total", nullptr, nullptr,
+                double(sum([](ThreadMetrics& t) -> auto& { return t.slowConsumerDrops; })));
+
+            Header(out, "netbox_udp_datagrams_received_total", "counter", "Datagrams accepted on --udp-port");
+            Sample(out, "netbox_udp_datagrams_received_total", nullptr, nullptr,
+                double(sum([](ThreadMetrics& t) -> auto& { return t.udpReceived; })));
+
+            Header(out, "netbox_udp_datagrams_sent_total", "counter", "Datagrams sent on --udp-port");
+            Sample(out, "netbox_udp_datagrams_sent_total", nullptr, nullptr,
+                double(sum([](ThreadMetrics& t) -> auto& { return t.udpSent; })));
+
+            Header(out, "netbox_udp_datagrams_rejected_total", "counter", "Datagrams with an unknown token or an old seq");
+            Sample(out, "netbox_udp_datagrams_rejected_total", nullptr, nullptr,
+                double(sum([](ThreadMetrics& t) -> auto& { return t.udpRejected; })));
+
+            Header(out, "netbox_resumes_total", "counter", "RESUME requests, by what the client got back");
+            Sample(out, "netbox_resumes_total", "result", "delta",
+                double(sum([](ThreadMetrics& t) -> auto& { return t.resumeDelta; })));
+            Sample(out, "netbox_resumes_total", "result", "snapshot",
+                double(sum([](ThreadMetrics& t) -> auto& { return t.resumeSnapshot; })));
+            Sample(out, "netbox_resumes_total", "result", "rejected",
+                double(sum([](ThreadMetrics& t) -> auto& { return t.resumeRejected; })));
+        }
+
+        // 한 카운터의 스레드 합 (scrape 밖에서 : --replay 요약)
+        template <typename F>
+        uint64_t Sum(F&& field)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            uint64_t total = 0;
+            for (auto& t : m_Threads)
+                total += field(*t).load(std::memory_order_relaxed);
+            return total;
+        }
+
+        static void Header(std::string& out, const char* name, const char* type, const char* help)
+        {
+            out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+            out += "# TYPE "; out += name; out += ' '; out += type; out += '\n';
+        }
+
+        // name{label="value"} v   (label == nullptr : no labels)
+        static void Sample(std::string& out, const char* name, const char* label, const char* value, double v,
+            const char* extraLabel = nullptr, const char* extraValue = nullptr)
+        {
+            out += name;
+            if (label || extraLabel)
+            {
+                out += '{';
+                if (label)
+                {
+                    out += label; out += "=\""; out += value; out += '"';
+                }
+                if (extraLabel)
+                {
+                    if (label) out += ',';
+                    out += extraLabel; out += "=\""; out += extraValue; out += '"';
+                }
+                out += '}';
+            }
+            char num[32];
+            std::snprintf(num, sizeof(num), " %.17g\n", v);
+            out += num;
+        }
+
+    private:
+        template <typename F>
+        void RenderHistogram(std::string& out, const char* name, const char* label, const char* value, F&& field)
+        {
+            const std::string bucket = std::string(name) + "_bucket";
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i <= kBuckets.size(); ++i)
+            {
+                for (auto& t : m_Threads)
+                    cumulative += field(*t).buckets[i].load(std::memory_order_relaxed);
+
+                char le[32];
+                if (i < kBuckets.size())
+                    std::snprintf(le, sizeof(le), "%g", kBuckets[i]);
+                else
+                    std::snprintf(le, sizeof(le), "+Inf");
+                Sample(out, bucket.c_str(), label, value, double(cumulative), "le", le);
+            }
+
+            uint64_t count = 0, sumNs = 0;
+            for (auto& t : m_Threads)
+            {
+                count += field(*t).count.load(std::memory_order_relaxed);
+                sumNs += field(*t).sumNs.load(std::memory_order_relaxed);
+            }
+            Sample(out, (std::string(name) + "_sum").c_str(), label, value, double(sumNs) * 1e-9);
+            Sample(out, (std::string(name) + "_count").c_str(), label, value, double(count));
+        }
+
+        std::mutex m_Mutex; // 등록과 scrape만
+        std::vector<std::unique_ptr<ThreadMetrics>> m_Threads;
+    };
+
+    // 스코프 시간을 h에 기록
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& h) : m_Histogram(h), m_Start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() { m_Histogram.Observe(std::chrono::steady_clock::now() - m_Start); }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Histogram& m_Histogram;
+        std::chrono::steady_clock::time_point m_Start;
+    };
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+// =====================================================
+// Pool : free lists for the server's hot allocations
+//
+// FreeList<Tag, Size> keeps blocks of one size. Every thread has a small
+// cache; only when it overflows or runs dry does it trade kBatch blocks
+// with a shared list under a mutex. A block may be returned on any thread
+// (an outbound buffer usually comes back on the session thread that
+// finished writing it, not the tick thread that filled it).
+// Blocks are never given back to the OS.
+//
+// Built on it :
+//   Allocator<T, Tag>  allocate_shared : Session + control block in one block
+//   AcquireBuffer()    outbound buffers; the std::string keeps its capacity
+//   AcquireRecvStorage RecvBuffer's first block
+//
+// The heap counters only move when a free list comes up empty or a pooled
+// string has to grow, so in steady state they stay flat.
+// =====================================================
+namespace Pool
+{
+    struct SessionTag {};
+    struct ControlTag {}; // shared_ptr control blocks of outbound buffers
+    struct BufferTag {};
+    struct RecvTag {};
+
+    struct Counters
+    {
+        std::atomic<uint64_t> heap{ 0 }; // free list가 비어서 new로 만든 블록
+    };
+
+    template <typename Tag>
+    Counters& Stats()
+    {
+        static Counters c;
+        return c;
+    }
+
+    template <typename Tag, size_t Size>
+    class FreeList
+    {
+    public:
+        static constexpr size_t kBatch = 64;
+        static constexpr size_t kCacheMax = kBatch * 2;
+
+        // nullptr : 어디에도 없다 (부른 쪽이 new로 만든다)
+        static void* Pop()
+        {
+            Cache& c = Local();
+            if (c.items.empty())
+                Move(Global().items, c.items, kBatch);
+            if (c.items.empty())
+                return nullptr;
+
+            void* p = c.items.back();
+            c.items.pop_back();
+            return p;
+        }
+
+        static void Push(void* p)
+        {
+            Cache& c = Local();
+            c.items.push_back(p); // reserve해 둔 자리
+            if (c.items.size() > kCacheMax)
+                Move(c.items, Global().items, kBatch);
+        }
+
+    private:
+        struct Shared
+        {
+            std::mutex mutex;
+            std::vector<void*> items;
+        };
+
+        struct Cache
+        {
+            Cache() { items.reserve(kCacheMax + 1); }
+            ~Cache() { Move(items, Global().items, items.size()); } // 스레드가 끝나면 전부 공유 목록으로
+            std::vector<void*> items;
+        };
+
+        static Shared& Global()
+        {
+            static Shared s;
+            return s;
+        }
+
+        static Cache& Local()
+        {
+            thread_local Cache c;
+            return c;
+        }
+
+        // 뒤에서 n개
+        static void Move(std::vector<void*>& from, std::vector<void*>& to, size_t n)
+        {
+            std::lock_guard<std::mutex> lock(Global().mutex);
+            n = (std::min)(n, from.size());
+            to.insert(to.end(), from.end() - n, from.end());
+            from.resize(from.size() - n);
+        }
+    };
+
+    // allocate_shared용. 한 개짜리 할당만 풀에서 (rebind된 control block 타입 크기로)
+    template <typename T, typename Tag>
+    struct Allocator
+    {
+        using value_type = T;
+        static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "pooled blocks come from plain operator new");
+
+        Allocator() = default;
+        template <typename U>
+        Allocator(const Allocator<U, Tag>&) {}
+
+        T* allocate(size_t n)
+        {
+            if (n == 1)
+            {
+                if (void* p = FreeList<Tag, sizeof(T)>::Pop())
+                    return static_cast<T*>(p);
+                Stats<Tag>().heap.fetch_add(1, std::memory_order_relaxed);
+            }
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* p, size_t n)
+        {
+            if (n == 1)
+                FreeList<Tag, sizeof(T)>::Push(p);
+            else
+                ::operator delete(p);
+        }
+
+        template <typename U> bool operator==(const Allocator<U, Tag>&) const { return true; }
+        template <typename U> bool operator!=(const Allocator<U, Tag>&) const { return false; }
+    };
+
+    // -------------------------
+    // Outbound buffers
+    // -------------------------
+    constexpr size_t kMaxKeptCapacity = 64 * 1024; // 이보다 커진 버퍼는 풀에 두지 않는다
+
+    struct BufferCounters
+    {
+        std::atomic<uint64_t> grown{ 0 };     // 쓰는 동안 capacity가 모자라 string이 할당했다
+        std::atomic<uint64_t> discarded{ 0 }; // kMaxKeptCapacity를 넘어서 버렸다
+    };
+
+    inline BufferCounters& BufferStats()
+    {
+        static BufferCounters c;
+        return c;
+    }
+
+    // 마지막 shared_ptr가 놓는 스레드에서 불린다
+    struct BufferReturn
+    {
+        size_t capacity; // 꺼낼 때
+
+        void operator()(std::string* s) const
+        {
+            if (s->capacity() > capacity)
+                BufferStats().grown.fetch_add(1, std::memory_order_relaxed);
+
+            if (s->capacity() > kMaxKeptCapacity)
+            {
+                BufferStats().discarded.fetch_add(1, std::memory_order_relaxed);
+                delete s;
+                return;
+            }
+
+            s->clear();
+            FreeList<BufferTag, sizeof(std::string)>::Push(s);
+        }
+    };
+
+    // 빈 string (capacity는 지난번 것 그대로)
+    inline std::shared_ptr<std::string> AcquireBuffer()
+    {
+        auto* s = static_cast<std::string*>(FreeList<BufferTag, sizeof(std::string)>::Pop());
+        if (!s)
+        {
+            Stats<BufferTag>().heap.fetch_add(1, std::memory_order_relaxed);
+            s = new std::string();
+        }
+        return std::shared_ptr<std::string>(s, BufferReturn{ s->capacity() }, Allocator<std::string, ControlTag>{});
+    }
+
+    // -------------------------
+    // RecvBuffer storage
+    // -------------------------
+    constexpr size_t kRecvBlock = 4096; // RecvBuffer 기본 크기, 자란 버퍼는 풀로 돌아오지 않는다
+
+    inline std::unique_ptr<char[]> AcquireRecvStorage()
+    {
+        if (void* p = FreeList<RecvTag, kRecvBlock>::Pop())
+            return std::unique_ptr<char[]>(static_cast<char*>(p));
+        Stats<RecvTag>().heap.fetch_add(1, std::memory_order_relaxed);
+        return std::unique_ptr<char[]>(new char[kRecvBlock]);
+    }
+
+    inline void ReleaseRecvStorage(std::unique_ptr<char[]> storage)
+    {
+        if (storage)
+            FreeList<RecvTag, kRecvBlock>::Push(storage.release());
+    }
+}
@@ -6,8 +6,117 @@
 #include <memory>
 #include <sstream>
 #include <array>
+#include <algorithm>
+#include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <functional>
+#include "../../Shared/BufferSequence.h"
+#include "../../Shared/Protocol.h"
+#include "../../Shared/RecvBuffer.h"
+#include "../../Shared/NetLog.h"
+#include "Log.h"
+#include "Metrics.h"
+#include "Pool.h"
 
 using boost::asio::ip::tcp;
+using boost::asio::ip::udp;
+
+// =====================================================
+// Config (command line)
+// =====================================================
+std::size_t g_WriteBatchLimit = 64 * 1024; // async_write     ִ Ʈ
+int g_ThreadCount = 1;                     // io_context::run  
+int g_TickRate = 30;                       // Hz. 0 = MOVE  εĳƮ
+int g_AoiBucketCells = 16;                 // AOI Ŷ   ()
+int g_AoiRadius = 3;                       //    (Ŷ, ߽  radius)
+int g_WorldHalfCells = 512;                //  ũ :  [-half, half] (ֹ , SPAWN/MOVE )
+std::size_t g_WriteQueueLimit = 4 * 1024 * 1024; //  write queue  (Ʈ).   Ŭ̾Ʈ ´. 0 = 
+uint16_t g_UdpPort = 0;                    // MOVE UDP ä. 0 = TCP
+int g_ResumeWindow = 10;                   // s.  v3    ΰ RESUME ٸ. 0 = 
+std::string g_RecordFile;                  // --record :  Ʈ  NetLog
+std::string g_ReplayFile;                  // --replay :    ٽ ,  óϸ 
+bool g_ReplayPaced = false;                // --replay-pace original : ϵ ð (⺻ max : ִ ӵ)
+
+// ܼ    : io    ٷ ư (--log-level, --log-rate, --log-sample)
+Logger g_Log;
+
+// 庰 ī/׷. --metrics-port Prometheus text format (0 = )
+Metrics::Registry g_Metrics;
+uint16_t g_MetricsPort = 0;
+
+// --record. Ḷ stream = ó  session key (RESUME key ٲ ״)
+NetLog::Writer g_Record;
+
+// =====================================================
+// World version
+//    ƽ ȣ (TICK <n> n).  ġ, ̴   ,
+// ֹ  ׶  ٿ д -> ٽ  Ŭ̾ƮԴ 
+//   Ŀ ٲ ͸  (RESUME, v3). --tick-rate 0̸   RESUME 
+// =====================================================
+std::chrono::steady_clock::time_point g_WorldStart = std::chrono::steady_clock::now();
+std::chrono::steady_clock::duration g_TickPeriod{ 0 };
+
+uint32_t WorldVersion()
+{
+    if (g_TickPeriod.count() <= 0)
+        return 0;
+    return uint32_t((std::chrono::steady_clock::now() - g_WorldStart) / g_TickPeriod);
+}
+
+bool ResumeEnabled() { return g_ResumeWindow > 0 && g_TickRate > 0; }
+
+// ֱ   ( ũ ring,      ).
+//  ִ  Ŀ :   ȿ WorldVersion() ´
+template <typename T>
+class VersionLog
+{
+public:
+    explicit VersionLog(std::size_t capacity) : m_Items(capacity) {}
+
+    void Push(uint32_t version, const T& item)
+    {
+        Entry& e = m_Items[m_Count % m_Items.size()];
+        if (m_Count >= m_Items.size())
+        {
+            m_Lost = e.version;
+            m_HasLost = true;
+        }
+        e = Entry{ version, item };
+        ++m_Count;
+    }
+
+    // since   ϳ  ʾҴ
+    bool Covers(uint32_t since) const { return !m_HasLost || m_Lost < since; }
+
+    //  since ̻   ͺ
+    template <typename F>
+    void ForEachSince(uint32_t since, F&& f) const
+    {
+        const uint64_t first = (m_Count > m_Items.size()) ? m_Count - m_Items.size() : 0;
+        uint64_t i = m_Count;
+        while (i > first && m_Items[(i - 1) % m_Items.size()].version >= since)
+            --i;
+        for (; i < m_Count; ++i)
+            f(m_Items[i % m_Items.size()].item);
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t version = 0;
+        T item{};
+    };
+
+    std::vector<Entry> m_Items;
+    uint64_t m_Count = 0;
+    uint32_t m_Lost = 0;    //      
+    bool m_HasLost = false;
+};
 
 // =====================================================
 // World State
@@ -17,297 +126,2869 @@ struct Block
     int key; // sessionKey
     int x;
     int z;
+    bool dirty = false; //  ƽ MOVE  
+};
+
+// sessionKey .  ִ ġ , Ŭ̾Ʈ  ġ Interest  ִ.
+//   : BlockShard::m_Mutex -> Interest::m_Mutex -> ObstacleMap::m_Mutex -> SessionRegistry::m_Mutex
+//           Interest::m_Mutex -> Session::m_OutboxMutex (leaf)
+struct BlockShard
+{
+    std::mutex m_Mutex;
+    std::unordered_map<int, Block> m_Blocks;
+    std::vector<int> m_Dirty; // ̹ ƽ  key (ߺ )
 };
 
-std::unordered_map<int, Block> g_Blocks;
-int g_NextSessionKey = 1;
+constexpr int kBlockShards = 16;
+std::array<BlockShard, kBlockShards> g_Blocks;
+
+BlockShard& ShardOf(int key) { return g_Blocks[unsigned(key) % kBlockShards]; }
+
+std::atomic<int> g_NextSessionKey{ 1 };
 
 // forward
 class Session;
-std::vector<std::shared_ptr<Session>> g_Sessions;
-
-void Broadcast(const std::string& msg);
 
 // =====================================================
-// Session
+// Session registry
+//   迭 ΰ,   ڱ  ȣ Ѵ.
+// Add / Remove  O(1) (Remove  ҿ swap).
+// ForEach ݹ ȿ Removeϸ ȸ  ڿ óѴ.
 // =====================================================
-class Session : public std::enable_shared_from_this<Session>
+class SessionRegistry
 {
 public:
-    Session(tcp::socket socket)
-        : m_Socket(std::move(socket))
-        , m_SessionKey(g_NextSessionKey++)
+    static constexpr std::size_t kNoSlot = std::size_t(-1);
+
+    void Add(std::shared_ptr<Session> session);
+    void Remove(Session* session);
+
+    template <typename F>
+    void ForEach(F&& f);
+
+    std::size_t Size()
     {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        return m_Sessions.size();
     }
 
-    void Start()
-    {
-        // 1.  Ű Ҵ
-        Send("ASSIGN " + std::to_string(m_SessionKey) + "\n");
+private:
+    void RemoveLocked(Session* session);
 
-        // 2.    
-        SendSnapshot();
+    std::shared_mutex m_Mutex;
+    std::vector<std::shared_ptr<Session>> m_Sessions;
 
-        DoRead();
+    // ForEach  尡 θ Remove (   ä Ÿ    )
+    static thread_local int t_Iterating;
+    static thread_local std::vector<Session*> t_PendingRemove;
+};
+
+thread_local int SessionRegistry::t_Iterating = 0;
+thread_local std::vector<Session*> SessionRegistry::t_PendingRemove;
+
+SessionRegistry g_Sessions;
+
+void Broadcast(const Protocol::Message& msg);
+
+template <typename Encode>
+void BroadcastEncoded(Encode&& encode);
+
+// =====================================================
+// Outbound buffers
+//   ڵ ޽   write queue Ѵ (immutable)
+// ۴ Pool::AcquireBuffer :     capacity  ä Ǯ ư
+// =====================================================
+using SharedBuffer = std::shared_ptr<const std::string>;
+
+void AppendEncoded(const Protocol::Message& msg, int version, std::string& out)
+{
+    char buf[Protocol::kMaxFrameSize];
+    size_t len = (version >= Protocol::kVersionBinary)
+        ? Protocol::EncodeBinary(msg, buf)
+        : Protocol::EncodeText(msg, buf, true);
+    out.append(buf, len);
+}
+
+SharedBuffer EncodeShared(const Protocol::Message& msg, int version)
+{
+    auto out = Pool::AcquireBuffer();
+    AppendEncoded(msg, version, *out);
+    return out;
+}
+
+//  write queue. տ  ޸𸮸  ʴ´ (deque  Ҵ/Ѵ)
+class BufferQueue
+{
+public:
+    bool empty() const { return m_Head == m_Items.size(); }
+    std::size_t size() const { return m_Items.size() - m_Head; }
+
+    auto begin() { return m_Items.begin() + std::ptrdiff_t(m_Head); }
+    auto end() { return m_Items.end(); }
+
+    void push_back(SharedBuffer buf) { m_Items.push_back(std::move(buf)); }
+
+    //  n ´
+    void pop_front(std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            m_Items[m_Head + i].reset();
+        m_Head += n;
+
+        if (m_Head == m_Items.size())
+            clear();
+        else if (m_Head >= kCompactAt && m_Head * 2 >= m_Items.size())
+        {
+            // и ť     :   ڸ  (  ϸ ű)
+            m_Items.erase(m_Items.begin(), m_Items.begin() + std::ptrdiff_t(m_Head));
+            m_Head = 0;
+        }
     }
 
-    void Send(const std::string& msg)
+    void clear()
     {
-        auto self = shared_from_this();
-        boost::asio::post(
-            m_Socket.get_executor(),
-            [this, self, msg]()
-            {
-                bool writing = !m_WriteQueue.empty();
-                m_WriteQueue.push_back(msg);
-                if (!writing)
-                    DoWrite();
-            });
+        m_Items.clear(); // capacity ״
+        m_Head = 0;
     }
 
 private:
-    // -------------------------
-    // Snapshot
-    // -------------------------
-    void SendSnapshot()
-    {
-        Send("SNAPSHOT_BEGIN\n");
+    static constexpr std::size_t kCompactAt = 256;
 
-        for (auto& [key, b] : g_Blocks)
-        {
-            Send(
-                "SPAWN " +
-                std::to_string(b.key) + " " +
-                std::to_string(b.x) + " " +
-                std::to_string(b.z) + "\n");
-        }
+    std::vector<SharedBuffer> m_Items;
+    std::size_t m_Head = 0;
+};
+
+// =====================================================
+// Obstacle layer
+//  ֹ ̴.   = 1 bit (1025x1025 = 128 KB).
+//  Ÿ  ȿ εĳƮ Ѵ.
+// ϴ    ȿ Ʈ   (Freeze) ű⼭ chunk
+// õõ ̴´.     ǿ εĳƮǹǷ  ´´.
+//  ̹  ִ  ù  Ʈ Ѵ (copy-on-write).
+// =====================================================
+using ObstacleBits = std::shared_ptr<const std::vector<uint64_t>>;
+
+//  ֹ  (б ,   д´)
+struct ObstacleImage
+{
+    int half = 0;
+    ObstacleBits bits;
 
-        Send("SNAPSHOT_END\n");
+    bool Test(int x, int z) const
+    {
+        const std::size_t i = std::size_t(z + half) * std::size_t(half * 2 + 1) + std::size_t(x + half);
+        return ((*bits)[i >> 6] >> (i & 63)) & 1;
     }
 
-    // -------------------------
-    // Read
-    // -------------------------
-    void DoRead()
+    int Rows() const { return half * 2 + 1; }
+
+    //  row chunk ϳ (v2 : OBSTACLE_ROWS  ϳ, v1 : ׸ŭ OBSTACLE_RUN ).
+    // Returns the next row.
+    int EncodeChunk(int version, int row, std::string& out) const;
+};
+
+class ObstacleMap
+{
+public:
+    void Init(int half)
     {
-        auto self = shared_from_this();
-        m_Socket.async_read_some(
-            boost::asio::buffer(m_ReadBuf),
-            [this, self](boost::system::error_code ec, std::size_t len)
-            {
-                if (ec)
-                {
+        m_Half = half;
+        m_Width = half * 2 + 1;
+        m_Bits = std::make_shared<std::vector<uint64_t>>((std::size_t(m_Width) * std::size_t(m_Width) + 63) / 64, 0);
+    }
 
-                    //⼭ ec ̿ؼ string ϴ . 
-                    //~ Ҹڿ θ   ~
-                    std::cout << "[DISCONNECT] sessionKey=" << m_SessionKey << "\n";
+    bool InBounds(int x, int z) const
+    {
+        return x >= -m_Half && x <= m_Half && z >= -m_Half && z <= m_Half;
+    }
 
-                    //
-                    auto it = g_Blocks.find(m_SessionKey);
+    // SPAWN / MOVE    ִ 
+    bool IsWalkable(int x, int z)
+    {
+        if (!InBounds(x, z))
+            return false;
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        return !Test(x, z);
+    }
 
-                    //std::cout << "g_Blocks.size(): " << g_Blocks.size() << std::endl;
+    // ٲ ο ˸.  ̰ų ״θ false.
+    bool Set(int x, int z, bool blocked)
+    {
+        if (!InBounds(x, z))
+            return false;
 
-                    if (it != g_Blocks.end())
-                    {
-                        //
-                        std::string despawnMsg =
-                            "DESPAWN " +
-                            std::to_string(m_SessionKey) + "\n";
-                            //std::to_string(m_SessionKey) + " " +
-                            //std::to_string(it->second.x) + " " +
-                            //std::to_string(it->second.z) + "\n";
-                        
-                        Broadcast(despawnMsg);
-
-                        g_Blocks.erase(it);
-                    }
+        std::unique_lock<std::shared_mutex> lock(m_Mutex);
+        if (Test(x, z) == blocked)
+            return false;
 
-                    auto sessionIt = std::find(g_Sessions.begin(), g_Sessions.end(), self);
-                    if (sessionIt != g_Sessions.end())
-                    {
-                        g_Sessions.erase(sessionIt);
-                    }
-                    
-                    return;
-                }
+        //     ̹  ִ
+        if (m_Bits.use_count() > 1)
+            m_Bits = std::make_shared<std::vector<uint64_t>>(*m_Bits);
 
-                m_Incoming.append(m_ReadBuf.data(), len);
+        const std::size_t i = Index(x, z);
+        (*m_Bits)[i >> 6] ^= uint64_t(1) << (i & 63);
 
-                std::size_t pos;
-                while ((pos = m_Incoming.find('\n')) != std::string::npos)
-                {
-                    std::string line = m_Incoming.substr(0, pos);
-                    m_Incoming.erase(0, pos + 1);
-                    HandleCommand(line);
-                }
+        const Protocol::Message edit{ blocked ? Protocol::Op::ObstacleSet : Protocol::Op::ObstacleClear,
+            0, int16_t(x), int16_t(z) };
+        m_Edits.Push(WorldVersion(), edit);
+        Broadcast(edit);
+        return true;
+    }
 
-                DoRead();
-            });
+    //  ¸ 󸰴. whileLocked()   ȿ Ҹ : ⼭ 
+    // εĳƮ  ø     ǿ .
+    template <typename F>
+    ObstacleImage Freeze(F&& whileLocked)
+    {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        whileLocked();
+        return ObstacleImage{ m_Half, m_Bits };
     }
 
-    // -------------------------
-    // Command handling
-    // -------------------------
-    void HandleCommand(const std::string& line)
+    // RESUME :  since    whileLocked(edits) ѱ. Freezeó
+    //   ̶ ⼭  εĳƮ  ø   .
+    // (kEdits) since    false
+    template <typename F>
+    bool Replay(uint32_t since, F&& whileLocked)
     {
-        std::istringstream iss(line);
-        std::string cmd;
-        iss >> cmd;
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        if (!m_Edits.Covers(since))
+            return false;
 
-        // =========================
-        // SPAWN <cellX> <cellZ>
-        // =========================
-        if (cmd == "SPAWN")
-        {
-            int x, z;
-            iss >> x >> z;
+        std::vector<Protocol::Message> edits;
+        m_Edits.ForEachSince(since, [&edits](const Protocol::Message& m) { edits.push_back(m); });
+        whileLocked(edits);
+        return true;
+    }
 
-            // Ǵ 1ȸ 
-            if (g_Blocks.find(m_SessionKey) != g_Blocks.end())
-                return;
+private:
+    std::size_t Index(int x, int z) const { return std::size_t(z + m_Half) * m_Width + std::size_t(x + m_Half); }
+    bool Test(int x, int z) const
+    {
+        const std::size_t i = Index(x, z);
+        return ((*m_Bits)[i >> 6] >> (i & 63)) & 1;
+    }
 
-            Block b;
-            b.key = m_SessionKey;
-            b.x = x;
-            b.z = z;
+    static constexpr std::size_t kEdits = 4096;
 
-            g_Blocks[m_SessionKey] = b;
+    std::shared_mutex m_Mutex;
+    int m_Half = 0;
+    int m_Width = 0;
+    std::shared_ptr<std::vector<uint64_t>> m_Bits;
+    VersionLog<Protocol::Message> m_Edits{ kEdits }; // ֱ  (RESUME)
+};
 
-            std::cout << "[SPAWN] key=" << m_SessionKey
-                << " (" << x << "," << z << ")\n";
+ObstacleMap g_Obstacles;
 
-            Broadcast(
-                "SPAWN " +
-                std::to_string(b.key) + " " +
-                std::to_string(b.x) + " " +
-                std::to_string(b.z) + "\n");
-        }
+// =====================================================
+// Interest management (AOI)
+//   g_AoiBucketCells ũ Ŷ ´.  ڱ  ִ
+// Ŷ  g_AoiRadius   (   Ŷ ).
+// SPAWN/MOVE/DESPAWN ش Ŷ  ִ ǿԸ ,
+// 踦  enter(SPAWN) / leave(DESPAWN) .
+//
+// Ŭ̾Ʈ  ƼƼ ̺Ʈ  m_Mutex ȿ  outbox δ
+// ->  ̺Ʈ  Ǻ ׻ ġѴ. ڵ   ,
+//   strand (Session::DrainOutbox) :  ȿ ε Ѵ.
+// Session* Leave()   ȿϴ (disconnect ο ȣ).
+// =====================================================
+class Interest
+{
+public:
+    //   κ + SNAPSHOT_END ,   (ֹ Ʈ  )
+    void Join(Session* session, int key);
+    //  ƿ  (RESUME) :  since Ŀ ٲ ͸   .
+    // onJoined() ֹ  ȿ Ҹ (Freeze ).  since 
+    // ƹ͵  ʰ false -> ü 
+    template <typename F>
+    bool Resume(Session* session, int key, uint32_t since, F&& onJoined);
+    //   (disconnect)
+    void Leave(int key);
 
-        // =========================
-        // MOVE <cellX> <cellZ>
-        // =========================
-        else if (cmd == "MOVE")
-        {
-            int x, z;
-            iss >> x >> z;
+    void Spawn(int key, int x, int z);
+    void Despawn(int key);
+    // moves : ̹ ƽ  ϵ (key ). tick != 0̸ ġ տ TICK
+    void ApplyMoves(const Protocol::Message* moves, size_t count, uint32_t tick = 0);
 
-            auto it = g_Blocks.find(m_SessionKey);
-            if (it == g_Blocks.end())
-                return; //  SPAWN  
+    // ٽ   ִ UDP MOVE  ִ (   ApplyMoves ҷ Ѵ)
+    bool HasRepeat() const { return m_HasRepeat.load(std::memory_order_relaxed); }
 
-            it->second.x = x;
-            it->second.z = z;
+private:
+    using BucketId = int64_t;
 
-            std::cout << "[MOVE] key=" << m_SessionKey
-                << " (" << x << "," << z << ")\n";
+    struct Bucket
+    {
+        std::vector<int> m_Blocks;   //  Ŷ ̴  key
+        std::vector<int> m_Watchers; //  Ŷ   key
+    };
 
-            Broadcast(
-                "MOVE " +
-                std::to_string(m_SessionKey) + " " +
-                std::to_string(x) + " " +
-                std::to_string(z) + "\n");
-        }
+    struct Visible
+    {
+        int x, z;          // Ŭ̾Ʈ   ġ
+        BucketId bucket;
+        uint32_t version;  //  ٲ  
+    };
 
-        // =========================
-        // DESPAWN <cellX> <cellZ>
-        //  ڵ  ν ϴ  ´  ...
-        // =========================
-        else if (cmd == "DESPAWN")
-        {
-            auto it = g_Blocks.find(m_SessionKey);
-            if (it == g_Blocks.end())
-                return;
+    // ̴  Ŷ  (̵, DESPAWN), Ǵ watcher AOI ߽ Ű  (view).
+    // Resume ׵  ̰   DESPAWN ⼭ 
+    struct Departure
+    {
+        int key = 0;
+        BucketId bucket = 0;
+        bool view = false;
+    };
 
-            std::cout << "[DESPAWN] key=" << m_SessionKey << "\n";
+    static constexpr size_t kDepartures = 32768;
 
-            Broadcast(
-                "DESPAWN " +
-                std::to_string(m_SessionKey) + "\n");
-        }
+    struct Watcher
+    {
+        Session* session = nullptr;
+        BucketId center = 0;
+        std::vector<Protocol::Message> events; // SPAWN/DESPAWN (enter/leave )
+        std::vector<Protocol::Message> moves;  // MOVE, key 
+        bool touched = false;                  // m_Touched ִ
+    };
 
+    static int FloorDiv(int a, int b) { return (a >= 0) ? a / b : -((-a + b - 1) / b); }
+    static BucketId MakeBucket(int bx, int bz) { return (BucketId(bx) << 32) | uint32_t(bz); }
+    static int BucketX(BucketId id) { return int(id >> 32); }
+    static int BucketZ(BucketId id) { return int(uint32_t(id)); }
 
+    static BucketId BucketOf(int x, int z)
+    {
+        return MakeBucket(FloorDiv(x, g_AoiBucketCells), FloorDiv(z, g_AoiBucketCells));
+    }
 
+    static bool Covers(BucketId center, BucketId b)
+    {
+        return std::abs(BucketX(b) - BucketX(center)) <= g_AoiRadius &&
+            std::abs(BucketZ(b) - BucketZ(center)) <= g_AoiRadius;
     }
 
-    // -------------------------
-    // Write
-    // -------------------------
-    void DoWrite()
+    template <typename F>
+    static void ForEachBucketAround(BucketId center, F&& f)
     {
-        auto self = shared_from_this();
-        boost::asio::async_write(
-            m_Socket,
-            boost::asio::buffer(m_WriteQueue.front()),
-            [this, self](boost::system::error_code ec, std::size_t)
-            {
-                if (ec)
-                    return;
+        for (int dz = -g_AoiRadius; dz <= g_AoiRadius; ++dz)
+            for (int dx = -g_AoiRadius; dx <= g_AoiRadius; ++dx)
+                f(MakeBucket(BucketX(center) + dx, BucketZ(center) + dz));
+    }
 
-                m_WriteQueue.pop_front();
-                if (!m_WriteQueue.empty())
-                    DoWrite();
-            });
+    static void EraseValue(std::vector<int>& v, int value)
+    {
+        auto it = std::find(v.begin(), v.end(), value);
+        if (it != v.end())
+        {
+            *it = v.back();
+            v.pop_back();
+        }
     }
 
-    const int getSessionKey() const { return m_SessionKey; };
+    Watcher* Touch(int watcherKey);
+    void Recenter(int watcherKey, BucketId center);
+    void Depart(int key, BucketId bucket, bool view);
+    void Flush(uint32_t tick = 0);
 
 private:
-    tcp::socket m_Socket;
-    int m_SessionKey;
-
-    std::array<char, 1024> m_ReadBuf;
-    std::string m_Incoming;
-    std::deque<std::string> m_WriteQueue;
+    std::mutex m_Mutex;
+    std::unordered_map<BucketId, Bucket> m_Buckets;
+    std::unordered_map<int, Visible> m_Visible;  // block key
+    std::unordered_map<int, Watcher> m_Watchers; // session key
+    std::vector<int> m_Touched;                  // outbox  watcher
+    std::vector<int> m_Repeat;                   //  ƽ UDP MOVE  watcher
+    std::atomic<bool> m_HasRepeat{ false };
+    std::vector<Protocol::Message> m_Snapshot;   // Join/Resume scratch (θ Ҵ ʴ´)
+    VersionLog<Departure> m_Departures{ kDepartures };
 };
 
+Interest g_Interest;
+
+//   忡  (, RESUME â )
+void RemoveBlock(int key)
+{
+    auto& shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock(shard.m_Mutex);
+    auto it = shard.m_Blocks.find(key);
+
+    //std::cout << "g_Blocks.size(): " << g_Blocks.size() << std::endl;
+
+    if (it != shard.m_Blocks.end())
+    {
+        //
+        g_Interest.Despawn(key);
+
+        shard.m_Blocks.erase(it);
+    }
+}
+
 // =====================================================
-// Broadcast helper
+// UDP channel (--udp-port)
+// MOVE TCP head-of-line blocking  . Ҿ  MOVE .
+//  ASSIGN Ǹ ū δ : ū ´ datagram ּҰ  
+// UDP ּҰ ǰ, Ŭ̾Ʈ kUdpFlagReceiving  ׶ 
+// TICK + MOVE ġ MOVE_ACK UDP  (Session::UdpReady).
+// ϰ ε ǥ  strand .
 // =====================================================
-void Broadcast(const std::string& msg)
+class UdpChannel
 {
-    for (auto& s : g_Sessions)
-        s->Send(msg);
-}
+public:
+    void Open(boost::asio::io_context& io, const udp::endpoint& endpoint);
+    bool IsOpen() const { return m_Socket != nullptr; }
+
+    // ƹ 忡. ū ٷ ְ ε strand  (0 = ä )
+    uint64_t Register(const std::shared_ptr<Session>& session, int key);
+    void Unregister(int key);
+    // RESUME :   ε(ū ״) ̾ key ű
+    void Rekey(int from, int to);
+
+    // datagram  kUdpServerHeader Ʈ  д (seq ⼭ ä).
+    //  ּҸ 𸣴 ̸ 
+    void Send(int key, std::shared_ptr<std::string> datagram);
+
+private:
+    struct Binding
+    {
+        std::weak_ptr<Session> session;
+        uint64_t token = 0;
+        udp::endpoint peer;
+        bool bound = false; // peer ȴ
+        uint32_t recvSeq = 0;
+        uint32_t sendSeq = 0;
+    };
+
+    void DoReceive();
+    void OnDatagram(std::size_t len);
+    void SendTo(Binding& b, std::shared_ptr<std::string> datagram);
+
+    std::unique_ptr<udp::socket> m_Socket;
+    std::array<char, 2048> m_RecvBuf;
+    udp::endpoint m_From;
+
+    std::unordered_map<int, Binding> m_Bindings; // session key
+    std::unordered_map<uint64_t, int> m_Tokens;  // token -> session key
+};
+
+UdpChannel g_Udp;
 
 // =====================================================
-// Accept loop
+// Resume table (--resume-window, v3)
+//      д.  key ū RESUMEϸ   
+//  ̾ް (Interest::Resume ٲ ͸ ), â   .
+//       𸣸 (half-open) RESUME    ´.
+// m_Mutex ȿ ٸ   ʴ´
 // =====================================================
-void DoAccept(tcp::acceptor& acceptor)
+class ResumeTable
 {
-    acceptor.async_accept(
-        [&](boost::system::error_code ec, tcp::socket socket)
-        {
-            if (!ec)
-            {
-                // g_NextSessionKey m_SessionKey  𸣰ڴ.  ߿ Ϻε.
-                std::cout << "[CONNECT] sessionKey=" << g_NextSessionKey << "\n";
-                auto session = std::make_shared<Session>(std::move(socket));
-                g_Sessions.push_back(session);
-                session->Start();
-            }
-            DoAccept(acceptor);
-        });
-}
+public:
+    enum class Claim { Resumed, Live, Rejected };
+
+    // â   1ʸ ġ
+    void Start(boost::asio::io_context& io);
+
+    // (v3) .  RESUME  ū (0  ). RESUME ̾  ū
+    // ٽ Ǵ :  ū     Ŭ̾Ʈ ƿ  ִ
+    uint32_t Register(const std::shared_ptr<Session>& session, int key, uint32_t token = 0);
+    //  : true   д (session ϵ  )
+    bool Suspend(int key, const Session* session);
+    void Forget(int key, const Session* session);
+
+    // Resumed :  ִ   (ǥ ).
+    // Live : ū ´µ   ִ (live  )
+    Claim TryClaim(int key, uint32_t token, std::shared_ptr<Session>& live);
+
+    std::size_t Suspended();
+
+private:
+    struct Entry
+    {
+        uint32_t token = 0;
+        std::weak_ptr<Session> live; //  ִ 
+        bool suspended = false;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void Schedule();
+    void Sweep();
+
+    std::mutex m_Mutex;
+    std::unordered_map<int, Entry> m_Entries; // session key
+    std::unique_ptr<boost::asio::steady_timer> m_Timer;
+};
+
+ResumeTable g_Resume;
 
 // =====================================================
-// main
+// Session
 // =====================================================
-int main()
+class Session : public std::enable_shared_from_this<Session>
 {
-    try
+public:
+    Session(tcp::socket socket)
+        : m_Socket(std::move(socket))
+        , m_SessionKey(g_NextSessionKey++)
+        , m_SessionKeySeen(m_SessionKey)
+        , m_Stream(uint32_t(m_SessionKey))
+        , m_Recv(Pool::AcquireRecvStorage(), Pool::kRecvBlock)
+        , m_ResumeTimer(m_Socket.get_executor())
+        , m_HelloTimer(m_Socket.get_executor())
     {
-        boost::asio::io_context io;
-        //tcp::acceptor acceptor(io, tcp::endpoint(tcp::v4(), 8080));
-        tcp::acceptor acceptor(io, tcp::endpoint(boost::asio::ip::make_address("172.21.1.35"), 8080));//
+    }
 
-        std::cout << "Server started on port 8080\n";
-        DoAccept(acceptor);
+    ~Session()
+    {
+        Pool::ReleaseRecvStorage(m_Recv.ReleaseStorage(Pool::kRecvBlock));
+    }
 
-        io.run();
+    void Start()
+    {
+        // 1.  Ű Ҵ (+ UDP Ʈ ū,  ϴ ִ  )
+        //     Ŭ̾Ʈ HELLO   ڿ .
+        //    kHelloTimeout ȿ ƹ   HELLO 𸣴 v1 Ŭ̾Ʈ : ڸ 
+        std::string assign = "ASSIGN " + std::to_string(m_SessionKey) + " ";
+        if (const uint64_t token = g_Udp.Register(shared_from_this(), m_SessionKey))
+            assign += std::to_string(g_UdpPort) + " " + std::to_string(token) + " ";
+        Send(assign + std::to_string(Protocol::kVersionLatest) + "\n");
+
+        if (g_Record.IsOpen())
+            g_Record.Append(NetLog::Kind::Open, m_Stream);
+
+        auto self = shared_from_this();
+        m_HelloTimer.expires_after(kHelloTimeout);
+        m_HelloTimer.async_wait(
+            [this, self](boost::system::error_code ec)
+            {
+                if (!ec && !m_Joined && !m_Resuming && !m_Disconnected)
+                    Join(Protocol::kVersionText);
+            });
+        DoRead();
+    }
+
+    // Encodes msg for this session's negotiated version.
+    void Send(const Protocol::Message& msg)
+    {
+        Send(EncodeShared(msg, m_Version));
+    }
+
+    void Send(const std::string& msg)
+    {
+        auto buf = Pool::AcquireBuffer();
+        buf->assign(msg);
+        Send(SharedBuffer(std::move(buf)));
+    }
+
+    // ۴  ʰ ͸ ť ״´
+    void Send(SharedBuffer buf)
+    {
+        auto self = shared_from_this();
+        boost::asio::post(
+            m_Socket.get_executor(),
+            [this, self, buf = std::move(buf)]() mutable { Deliver(std::move(buf)); });
+    }
+
+    int GetVersion() const { return m_Version.load(std::memory_order_relaxed); }
+
+    // Interest  ȿ :  ؼ outbox ״´ (ڵ strand DrainOutbox).
+    // tick != 0̸ moves տ TICK. UDP   ƽ ٽ  MOVE Բ ƴ´
+    void QueueWorld(const std::vector<Protocol::Message>& events, uint32_t tick,
+        const std::vector<Protocol::Message>& moves)
+    {
+        QueueOutbox([&]()
+            {
+                m_Outbox.insert(m_Outbox.end(), events.begin(), events.end());
+                if (tick != 0)
+                {
+                    m_Outbox.push_back(Protocol::Message{ Protocol::Op::Tick, int32_t(tick), int16_t(g_TickRate) });
+                    m_UdpRepeat.store(true, std::memory_order_relaxed);
+                }
+                m_Outbox.insert(m_Outbox.end(), moves.begin(), moves.end());
+            });
+    }
+
+    //  (Join/Resume) SPAWN/DESPAWN + SNAPSHOT_END. version :    
+    void QueueSnapshot(const std::vector<Protocol::Message>& entities, uint32_t version)
+    {
+        QueueOutbox([&]()
+            {
+                m_Outbox.insert(m_Outbox.end(), entities.begin(), entities.end());
+                m_Outbox.push_back(Protocol::Message{ Protocol::Op::SnapshotEnd, int32_t(version) });
+            });
+    }
+
+    // ٽ   ִ UDP MOVE Ҵ (Ǵ  DrainOutbox   ƽ ִ)
+    bool UdpRepeat() const { return m_UdpRepeat.load(std::memory_order_relaxed); }
+
+    //   Ǹ Broadcast  (ٸ 忡 д´)
+    bool IsJoined() const { return m_Joined.load(std::memory_order_acquire); }
+
+    // UdpChannel strand : MOVE UDP ޴´ (  ߿ؼ TCPθ)
+    void ReceiveDatagram(const Protocol::Message& msg)
+    {
+        if (msg.op != Protocol::Op::Move)
+            return;
+
+        auto self = shared_from_this();
+        boost::asio::post(
+            m_Socket.get_executor(),
+            [this, self, msg]()
+            {
+                if (!m_Disconnected && IsJoined() && GetVersion() >= Protocol::kVersionBinary)
+                    HandleCommand(msg);
+            });
+    }
+
+    // Ŭ̾Ʈ  datagram ް ִ -> MOVE ġ MOVE_ACK UDP (v2)
+    void SetUdpReady()
+    {
+        if (GetVersion() >= Protocol::kVersionBinary)
+            m_UdpReady.store(true, std::memory_order_relaxed);
+    }
+
+    bool UdpReady() const { return m_UdpReady.load(std::memory_order_relaxed); }
+
+    // ٸ   key RESUMEߴ :     (бⰡ ϸ鼭 )
+    void Kick()
+    {
+        auto self = shared_from_this();
+        boost::asio::post(m_Socket.get_executor(),
+            [this, self]()
+            {
+                boost::system::error_code ignored;
+                m_Socket.close(ignored);
+            });
+    }
+
+    // metrics scrape (ƹ 忡). ť ũ  PublishQueue 
+    int SessionKey() const { return m_SessionKeySeen.load(std::memory_order_relaxed); }
+    std::size_t QueuedBytes() const { return m_QueuedBytesSeen.load(std::memory_order_relaxed); }
+    std::size_t QueueDepth() const { return m_QueueDepthSeen.load(std::memory_order_relaxed); }
+
+    // --record stream id (ٲ ʴ´)
+    uint32_t RecordStream() const { return m_Stream; }
+
+private:
+    // -------------------------
+    // Snapshot
+    // -------------------------
+    // SNAPSHOT_BEGIN, ֹ chunk ( ŭ ׶׶ ),  
+    // Interest::Join AOI  ϰ SNAPSHOT_END .
+    // Ʈ  εĳƮ m_Deferred Ҵٰ ֹ ڿ δ.
+    void Join(int version, uint32_t keepToken = 0)
+    {
+        m_HelloTimer.cancel();
+        version = std::clamp(version, Protocol::kVersionText, Protocol::kVersionLatest);
+        m_Version.store(version, std::memory_order_relaxed);
+
+        m_Streaming = true;
+        Enqueue(EncodeShared(Protocol::Message{ Protocol::Op::SnapshotBegin }, version));
+        OfferResume(keepToken);
+
+        m_Snapshot = g_Obstacles.Freeze([this] { m_Joined.store(true, std::memory_order_release); });
+        m_SnapshotRow = 0;
+        PumpSnapshot();
+    }
+
+    // write queue g_WriteBatchLimit Ʒ    chunk
+    // ->  Ŭ̾ƮԴ   , Ǵ ޸𸮴 chunk  .
+    // m_Deferred  ʴ´ : Ʈ  Ƿ  Ʈ 
+    void PumpSnapshot()
+    {
+        while (m_Streaming && !m_Disconnected && m_QueuedBytes < g_WriteBatchLimit)
+        {
+            if (m_SnapshotRow >= m_Snapshot.Rows())
+            {
+                FinishSnapshot();
+                return;
+            }
+
+            auto chunk = Pool::AcquireBuffer();
+            m_SnapshotRow = m_Snapshot.EncodeChunk(GetVersion(), m_SnapshotRow, *chunk);
+            if (!chunk->empty())
+                Enqueue(std::move(chunk));
+        }
+    }
+
+    void FinishSnapshot()
+    {
+        m_Streaming = false;
+        m_Snapshot = ObstacleImage{};
+
+        //  ڿ  
+        m_QueuedBytes += m_DeferredBytes;
+        m_DeferredBytes = 0;
+        for (auto& buf : m_Deferred)
+            PushWrite(std::move(buf));
+        m_Deferred.clear();
+        PublishQueue();
+
+        //  AOI  ϸ  ޴´
+        g_Interest.Join(this, m_SessionKey);
+    }
+
+    // v3 :  RESUME  ū.    --resume-window   д
+    void OfferResume(uint32_t keepToken = 0)
+    {
+        if (GetVersion() < Protocol::kVersionResume || !ResumeEnabled())
+            return;
+        const uint32_t token = g_Resume.Register(shared_from_this(), m_SessionKey, keepToken);
+        Enqueue(EncodeShared(Protocol::Message{ Protocol::Op::ResumeToken, int32_t(token) }, GetVersion()));
+    }
+
+    // -------------------------
+    // Resume
+    // -------------------------
+    static constexpr auto kHelloTimeout = std::chrono::milliseconds(500); // Start
+    static constexpr auto kResumeRetry = std::chrono::milliseconds(20);
+    static constexpr int  kResumeAttempts = 50; // x kResumeRetry :   Ǳ⸦ ٸ
+
+    // RESUME <key> <token> <version>.  Ʈ v3 ̳ʸ
+    void StartResume(std::string_view args)
+    {
+        auto next = [&args](auto& v)
+            {
+                while (!args.empty() && args.front() == ' ')
+                    args.remove_prefix(1);
+                auto [ptr, ec] = std::from_chars(args.data(), args.data() + args.size(), v);
+                args.remove_prefix(std::size_t(ptr - args.data()));
+                return ec == std::errc();
+            };
+
+        uint32_t version = 0;
+        if (!next(m_ResumeKey) || !next(m_ResumeToken) || !next(version))
+            m_ResumeKey = 0;
+
+        // UDP TICK TCP    ִ : 1 պ (UDP MOVE ݺ â ˳)
+        m_ResumeSince = (version > uint32_t(g_TickRate)) ? version - uint32_t(g_TickRate) : 0;
+        m_ResumeAttempts = 0;
+        m_Resuming = true;
+        m_Version.store(Protocol::kVersionResume, std::memory_order_relaxed);
+        TryResume();
+    }
+
+    void TryResume()
+    {
+        if (m_Disconnected)
+            return;
+
+        std::shared_ptr<Session> live;
+        const ResumeTable::Claim claim = (ResumeEnabled() && m_ResumeKey != 0)
+            ? g_Resume.TryClaim(m_ResumeKey, m_ResumeToken, live)
+            : ResumeTable::Claim::Rejected;
+
+        if (claim == ResumeTable::Claim::Live && ++m_ResumeAttempts <= kResumeAttempts)
+        {
+            //       𸥴.    ٸ
+            live->Kick();
+            auto self = shared_from_this();
+            m_ResumeTimer.expires_after(kResumeRetry);
+            m_ResumeTimer.async_wait(
+                [this, self](boost::system::error_code ec)
+                {
+                    if (!ec)
+                        TryResume();
+                });
+            return;
+        }
+
+        m_Resuming = false;
+        if (claim == ResumeTable::Claim::Resumed)
+        {
+            Adopt();
+            return;
+        }
+
+        // 𸣴  / ū Ʋ / â  : HELLO 3   
+        g_Log.Info(LogCategory::Net, "RESUME rejected key=%d, new sessionKey=%d", m_ResumeKey, m_SessionKey);
+        Metrics::Add(g_Metrics.Local().resumeRejected, 1);
+        Enqueue(EncodeShared(Protocol::Message{ Protocol::Op::Resume, m_SessionKey }, GetVersion()));
+        Join(Protocol::kVersionResume);
+    }
+
+    //  ִ    ̾޴´.  忡 ״ ִ
+    void Adopt()
+    {
+        g_Log.Info(LogCategory::Net, "RESUME sessionKey=%d (connection %d)", m_ResumeKey, m_SessionKey);
+        g_Udp.Rekey(m_SessionKey, m_ResumeKey); // ASSIGN Ǿ  UDP ū ״ 
+        m_SessionKey = m_ResumeKey;
+        m_SessionKeySeen.store(m_SessionKey, std::memory_order_relaxed);
+
+        const int version = GetVersion();
+        Enqueue(EncodeShared(Protocol::Message{ Protocol::Op::Resume, m_SessionKey }, version));
+
+        if (g_Interest.Resume(this, m_SessionKey, m_ResumeSince,
+            [this] { m_Joined.store(true, std::memory_order_release); }))
+        {
+            Metrics::Add(g_Metrics.Local().resumeDelta, 1);
+            OfferResume(m_ResumeToken);
+            return;
+        }
+
+        //  since  : key ״,  
+        Metrics::Add(g_Metrics.Local().resumeSnapshot, 1);
+        Join(version, m_ResumeToken);
+    }
+
+    // -------------------------
+    // Read
+    // -------------------------
+    void DoRead()
+    {
+        //      ٷ 
+        char* dst = m_Recv.Prepare();
+        if (m_Recv.Space() == 0)
+        {
+            g_Log.Warn(LogCategory::Protocol, "receive buffer overflow, sessionKey=%d", m_SessionKey);
+            boost::system::error_code ignored;
+            m_Socket.close(ignored);
+            OnDisconnect();
+            return;
+        }
+
+        auto self = shared_from_this();
+        m_Socket.async_read_some(
+            boost::asio::buffer(dst, m_Recv.Space()),
+            [this, self, dst](boost::system::error_code ec, std::size_t len)
+            {
+                if (ec)
+                {
+
+                    //⼭ ec ̿ؼ string ϴ . 
+                    //~ Ҹڿ θ   ~
+                    OnDisconnect();
+                    return;
+                }
+
+                if (g_Record.IsOpen())
+                    g_Record.Append(NetLog::Kind::Data, m_Stream, dst, len);
+                m_Recv.Commit(len);
+                Metrics::Add(g_Metrics.Local().bytesReceived, len);
+
+                std::string_view line;
+                while (m_Version < Protocol::kVersionBinary && m_Recv.NextLine(line))
+                {
+                    HandleLine(line);
+                }
+
+                if (m_Version >= Protocol::kVersionBinary && !ReadFrames())
+                {
+                    g_Log.Warn(LogCategory::Protocol, "bad frame, sessionKey=%d", m_SessionKey);
+                    boost::system::error_code ignored;
+                    m_Socket.close(ignored);
+                }
+
+                DoRead();
+            });
+    }
+
+    void OnDisconnect()
+    {
+        g_Log.Info(LogCategory::Net, "DISCONNECT sessionKey=%d", m_SessionKey);
+        if (g_Record.IsOpen())
+            g_Record.Append(NetLog::Kind::Close, m_Stream);
+        m_Disconnected = true; // Ʈ ̸ Interest::Join  ʴ´
+        m_HelloTimer.cancel();
+        m_UdpReady.store(false, std::memory_order_relaxed);
+        g_Udp.Unregister(m_SessionKey);
+
+        // v3 :   ΰ RESUME ٸ (DESPAWN    )
+        bool suspended = false;
+        if (m_Leaving)
+            g_Resume.Forget(m_SessionKey, this);
+        else
+            suspended = g_Resume.Suspend(m_SessionKey, this);
+
+        if (suspended)
+            g_Log.Info(LogCategory::Net, "SUSPEND sessionKey=%d (%d s)", m_SessionKey, g_ResumeWindow);
+        else
+            RemoveBlock(m_SessionKey);
+
+        g_Interest.Leave(m_SessionKey);
+
+        g_Sessions.Remove(this);
+    }
+
+    // v1 : one text line (view into m_Recv)
+    void HandleLine(std::string_view line)
+    {
+        // HELLO <version> :  .  Ʈ ̳ʸ
+        if (!m_Joined && line.substr(0, 6) == "HELLO ")
+        {
+            int version = Protocol::kVersionText;
+            std::from_chars(line.data() + 6, line.data() + line.size(), version);
+            Join(version);
+            return;
+        }
+
+        // RESUME <key> <token> <version> :  v3 Ŭ̾Ʈ ƿԴ
+        if (!m_Joined && !m_Resuming && line.substr(0, 7) == "RESUME ")
+        {
+            StartResume(line.substr(7));
+            return;
+        }
+
+        // HELLO     Ŭ̾Ʈ
+        if (!m_Joined)
+            Join(Protocol::kVersionText);
+
+        Protocol::Message msg;
+        if (Protocol::DecodeText(line, msg, false))
+            HandleCommand(msg);
+    }
+
+    // v2 : as many complete frames as are buffered. false on a malformed frame.
+    bool ReadFrames()
+    {
+        for (;;)
+        {
+            std::string_view data = m_Recv.Data();
+            int used = Protocol::DecodeFrame(data.data(), data.size(),
+                [this](const Protocol::Message& msg) { HandleCommand(msg); });
+            if (used < 0)
+                return false;
+            if (used == 0)
+                break;
+
+            m_Recv.Consume(used);
+        }
+        return true;
+    }
+
+    // -------------------------
+    // Command handling
+    // -------------------------
+    void HandleCommand(const Protocol::Message& msg)
+    {
+        // RESUME  ٸ  :    𸥴
+        if (m_Resuming)
+            return;
+
+        Metrics::ThreadMetrics& metrics = g_Metrics.Local();
+        const size_t op = (std::min)(size_t(msg.op), Metrics::kOpSlots - 1);
+        Metrics::Add(metrics.received[op], 1);
+        Metrics::ScopedTimer timer(metrics.handle[op]);
+
+        // =========================
+        // OBSTACLE_SET / OBSTACLE_CLEAR <cellX> <cellZ>
+        // ϰ  ->    ֹ ʸ
+        // =========================
+        if (msg.op == Protocol::Op::ObstacleSet || msg.op == Protocol::Op::ObstacleClear)
+        {
+            const bool blocked = (msg.op == Protocol::Op::ObstacleSet);
+            if (g_Obstacles.Set(msg.x, msg.z, blocked))
+            {
+                g_Log.Info(LogCategory::Obstacle, "key=%d %s (%d,%d)",
+                    m_SessionKey, blocked ? "set" : "clear", int(msg.x), int(msg.z));
+            }
+            return;
+        }
+
+        //    ڱ ϸ ǵ帰 -> ڱ 常 ٴ
+        auto& shard = ShardOf(m_SessionKey);
+        std::lock_guard<std::mutex> lock(shard.m_Mutex);
+        auto& blocks = shard.m_Blocks;
+
+        // =========================
+        // SPAWN <cellX> <cellZ>
+        // =========================
+        if (msg.op == Protocol::Op::Spawn)
+        {
+            int x = msg.x, z = msg.z;
+
+            // Ǵ 1ȸ 
+            if (blocks.find(m_SessionKey) != blocks.end())
+                return;
+
+            if (!g_Obstacles.IsWalkable(x, z))
+            {
+                g_Log.Info(LogCategory::Spawn, "rejected key=%d (%d,%d)", m_SessionKey, x, z);
+                return;
+            }
+
+            Block b;
+            b.key = m_SessionKey;
+            b.x = x;
+            b.z = z;
+
+            blocks[m_SessionKey] = b;
+
+            g_Log.Info(LogCategory::Spawn, "key=%d (%d,%d)", m_SessionKey, x, z);
+
+            g_Interest.Spawn(b.key, b.x, b.z);
+        }
+
+        // =========================
+        // MOVE <cellX> <cellZ> [seq]
+        // =========================
+        else if (msg.op == Protocol::Op::Move)
+        {
+            int x = msg.x, z = msg.z;
+
+            auto it = blocks.find(m_SessionKey);
+            if (it == blocks.end())
+                return; //  SPAWN  
+
+            //   /  δ  .  ִ ġ ״ -> ACK Ŭ̾Ʈ  ǵ
+            if (!g_Obstacles.IsWalkable(x, z))
+            {
+                g_Log.Info(LogCategory::Move, "rejected key=%d (%d,%d)", m_SessionKey, x, z);
+                SendMoveAck(msg.key, it->second);
+                return;
+            }
+
+            it->second.x = x;
+            it->second.z = z;
+            SendMoveAck(msg.key, it->second);
+
+            g_Log.Info(LogCategory::Move, "key=%d (%d,%d)", m_SessionKey, x, z);
+
+            if (g_TickRate <= 0)
+            {
+                Protocol::Message move{ Protocol::Op::Move, m_SessionKey, int16_t(x), int16_t(z) };
+                g_Interest.ApplyMoves(&move, 1);
+            }
+            else if (!it->second.dirty)
+            {
+                //  ƽ  MOVE  ġ ϳ 
+                it->second.dirty = true;
+                shard.m_Dirty.push_back(m_SessionKey);
+            }
+        }
+
+        // =========================
+        // DESPAWN <cellX> <cellZ>
+        //  ڵ  ν ϴ  ´  ...
+        // =========================
+        else if (msg.op == Protocol::Op::Despawn)
+        {
+            auto it = blocks.find(m_SessionKey);
+            if (it == blocks.end())
+                return;
+
+            g_Log.Info(LogCategory::Despawn, "key=%d", m_SessionKey);
+
+            m_Leaving = true; //   : ܵ RESUME ٸ ʴ´
+            g_Interest.Despawn(m_SessionKey);
+        }
+
+
+
+    }
+
+    // ϴ Ŭ̾ƮԸ (seq 0 =  Ŭ̾Ʈ, ACK 𸥴).
+    // ƽ ٸ ʰ ٷ  : ٸ  MOVE ġʹ 
+    void SendMoveAck(int32_t seq, const Block& b)
+    {
+        if (seq == 0)
+            return;
+
+        const Protocol::Message ack{ Protocol::Op::MoveAck, seq, int16_t(b.x), int16_t(b.z) };
+        if (!UdpReady())
+        {
+            Send(ack);
+            return;
+        }
+
+        auto datagram = Pool::AcquireBuffer();
+        datagram->assign(Protocol::kUdpServerHeader, '\0');
+        AppendEncoded(ack, Protocol::kVersionBinary, *datagram);
+        g_Udp.Send(m_SessionKey, std::move(datagram));
+    }
+
+    // -------------------------
+    // Outbox (Interest)
+    // -------------------------
+    template <typename F>
+    void QueueOutbox(F&& fill)
+    {
+        std::lock_guard<std::mutex> lock(m_OutboxMutex);
+        fill();
+        if (m_DrainPosted)
+            return;
+        m_DrainPosted = true;
+        auto self = shared_from_this();
+        boost::asio::post(m_Socket.get_executor(), [this, self]() { DrainOutbox(); });
+    }
+
+    // strand  :   ڵؼ Deliver (̺Ʈ , ״ TICK + MOVE ġ).
+    // UDP  TICK + MOVE ġ datagram
+    void DrainOutbox()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_OutboxMutex);
+            m_Draining.swap(m_Outbox);
+            m_DrainPosted = false;
+        }
+
+        if (!m_Disconnected)
+        {
+            const int version = GetVersion();
+            auto out = Pool::AcquireBuffer();
+            for (size_t i = 0; i < m_Draining.size();)
+            {
+                const Protocol::Message& m = m_Draining[i];
+                if (m.op == Protocol::Op::SnapshotEnd)
+                {
+                    // v3 : SNAPSHOT_END  TICK     ( RESUME )
+                    if (version >= Protocol::kVersionResume && ResumeEnabled())
+                        AppendEncoded(Protocol::Message{ Protocol::Op::Tick, m.key, int16_t(g_TickRate) }, version, *out);
+                    AppendEncoded(Protocol::Message{ Protocol::Op::SnapshotEnd }, version, *out);
+                    ++i;
+                }
+                else if (m.op == Protocol::Op::Tick || m.op == Protocol::Op::Move)
+                {
+                    const uint32_t tick = (m.op == Protocol::Op::Tick) ? uint32_t(m.key) : 0;
+                    const size_t begin = (m.op == Protocol::Op::Tick) ? i + 1 : i;
+                    size_t end = begin;
+                    while (end < m_Draining.size() && m_Draining[end].op == Protocol::Op::Move)
+                        ++end;
+                    AppendMoves(m_Draining.data() + begin, end - begin, tick, version, *out);
+                    i = end;
+                }
+                else
+                {
+                    AppendEncoded(m, version, *out);
+                    ++i;
+                }
+
+                if (out->size() >= Protocol::kMaxBatchPayload)
+                {
+                    Deliver(SharedBuffer(std::move(out)));
+                    out = Pool::AcquireBuffer();
+                }
+            }
+            if (!out->empty())
+                Deliver(SharedBuffer(std::move(out)));
+        }
+        m_Draining.clear();
+
+        std::lock_guard<std::mutex> lock(m_OutboxMutex);
+        if (m_Outbox.empty())
+            m_UdpRepeat.store(!m_UdpSent.empty(), std::memory_order_relaxed);
+    }
+
+    void AppendMoves(const Protocol::Message* moves, size_t count, uint32_t tick, int version, std::string& out)
+    {
+        if (UdpReady())
+        {
+            SendDatagrams(moves, count, tick);
+            return;
+        }
+
+        // Ŭ̾Ʈ  ۰  ġ  ð ȴ
+        if (tick != 0 && count > 0)
+            AppendEncoded(Protocol::Message{ Protocol::Op::Tick, int32_t(tick), int16_t(g_TickRate) }, version, out);
+
+        if (version >= Protocol::kVersionBinary)
+        {
+            Protocol::EncodeMoveBatch(moves, count, out);
+        }
+        else
+        {
+            char buf[Protocol::kMaxFrameSize];
+            for (size_t i = 0; i < count; ++i)
+                out.append(buf, Protocol::EncodeText(moves[i], buf, true));
+        }
+    }
+
+    // TICK + MOVE datagram ũ  .    MOVE  datagram
+    // Ҿ  MOVE  ״ Ʋ -> kUdpRepeatDelay     MOVE
+    //  MOVE    ƴ´.  ̴  ٽ  ʴ´
+    void SendDatagrams(const Protocol::Message* moves, size_t count, uint32_t tick)
+    {
+        if (tick != 0)
+        {
+            const uint32_t repeatTicks = uint32_t((std::max)(1, int(kUdpRepeatDelay * g_TickRate + 0.5)));
+
+            //   key .  key ̹ ƽ  ̱
+            std::vector<Protocol::Message>& merged = m_UdpMerged;
+            std::vector<SentMove>& sent = m_UdpSentScratch;
+            merged.clear();
+            sent.clear();
+            size_t i = 0, j = 0;
+            while (i < count || j < m_UdpSent.size())
+            {
+                if (j == m_UdpSent.size() || (i < count && moves[i].key <= m_UdpSent[j].move.key))
+                {
+                    if (j < m_UdpSent.size() && m_UdpSent[j].move.key == moves[i].key)
+                        ++j;
+                    merged.push_back(moves[i]);
+                    sent.push_back(SentMove{ moves[i++], tick });
+                }
+                else if (tick - m_UdpSent[j].tick >= repeatTicks)
+                {
+                    merged.push_back(m_UdpSent[j++].move);
+                }
+                else
+                {
+                    sent.push_back(m_UdpSent[j++]);
+                }
+            }
+
+            m_UdpSent.swap(sent);
+            moves = merged.data();
+            count = merged.size();
+        }
+
+        if (count == 0)
+            return;
+
+        char buf[Protocol::kMaxFrameSize];
+        const Protocol::Message stamp{ Protocol::Op::Tick, int32_t(tick), int16_t(g_TickRate) };
+        for (size_t i = 0; i < count; i += Protocol::kUdpMovesPerDatagram)
+        {
+            auto d = Pool::AcquireBuffer();
+            d->assign(Protocol::kUdpServerHeader, '\0');
+            if (tick != 0)
+                d->append(buf, Protocol::EncodeBinary(stamp, buf));
+            Protocol::EncodeMoveBatch(moves + i, (std::min)(Protocol::kUdpMovesPerDatagram, count - i), *d);
+            g_Udp.Send(m_SessionKey, std::move(d));
+        }
+    }
+
+    // -------------------------
+    // Write
+    // -------------------------
+    // strand  : ť  ѱ backpressure    (εĳƮ
+    // ٸ ǵ )  Ŭ̾Ʈ ´
+    void Deliver(SharedBuffer buf)
+    {
+        if (!m_Socket.is_open())
+            return;
+
+        if (g_WriteQueueLimit > 0 && m_QueuedBytes + m_DeferredBytes + buf->size() > g_WriteQueueLimit)
+        {
+            g_Log.Warn(LogCategory::Backpressure, "write queue %zu bytes over limit, dropping sessionKey=%d",
+                m_QueuedBytes + m_DeferredBytes, m_SessionKey);
+            Metrics::Add(g_Metrics.Local().slowConsumerDrops, 1);
+            boost::system::error_code ignored;
+            m_Socket.close(ignored); // бⰡ ϸ鼭 OnDisconnect
+            return;
+        }
+
+        if (m_Streaming)
+        {
+            m_DeferredBytes += buf->size();
+            m_Deferred.push_back(std::move(buf));
+            PublishQueue();
+            return;
+        }
+        Enqueue(std::move(buf));
+    }
+
+    void Enqueue(SharedBuffer buf)
+    {
+        m_QueuedBytes += buf->size();
+        PushWrite(std::move(buf));
+        PublishQueue();
+    }
+
+    // metrics scrape ٸ 忡 д 纻
+    void PublishQueue()
+    {
+        m_QueuedBytesSeen.store(m_QueuedBytes + m_DeferredBytes, std::memory_order_relaxed);
+        m_QueueDepthSeen.store(m_WriteQueue.size() + m_Deferred.size(), std::memory_order_relaxed);
+    }
+
+    void PushWrite(SharedBuffer buf)
+    {
+        bool writing = !m_WriteQueue.empty();
+        m_WriteQueue.push_back(std::move(buf));
+        if (!writing)
+            DoWrite();
+    }
+
+    // ť  ۸ g_WriteBatchLimit  async_write    (gather)
+    void DoWrite()
+    {
+        m_WriteBatch.clear();
+        std::size_t bytes = 0;
+        for (auto& buf : m_WriteQueue)
+        {
+            if (!m_WriteBatch.empty() && bytes + buf->size() > g_WriteBatchLimit)
+                break;
+            m_WriteBatch.push_back(boost::asio::buffer(*buf));
+            bytes += buf->size();
+        }
+
+        auto self = shared_from_this();
+        boost::asio::async_write(
+            m_Socket,
+            BufferSequenceView(m_WriteBatch),
+            [this, self, bytes](boost::system::error_code ec, std::size_t)
+            {
+                if (ec)
+                    return;
+
+                m_QueuedBytes -= bytes;
+                m_WriteQueue.pop_front(m_WriteBatch.size());
+                PublishQueue();
+                Metrics::Add(g_Metrics.Local().bytesSent, bytes);
+                if (!m_WriteQueue.empty())
+                    DoWrite();
+
+                //     chunk (DoWrite  : ť   Enqueue ⸦ Ѵ)
+                PumpSnapshot();
+            });
+    }
+
+    const int getSessionKey() const { return m_SessionKey; };
+
+private:
+    friend class SessionRegistry;
+
+    tcp::socket m_Socket;
+    int m_SessionKey;                    // RESUME ̾ key ٲ۴ (strand)
+    std::atomic<int> m_SessionKeySeen;   // SessionKey()
+    const uint32_t m_Stream;             // RecordStream()
+    std::atomic<int> m_Version{ Protocol::kVersionText };
+    std::atomic<bool> m_Joined{ false };
+    std::atomic<bool> m_UdpReady{ false };
+
+    RecvBuffer m_Recv;
+    BufferQueue m_WriteQueue;
+    std::vector<boost::asio::const_buffer> m_WriteBatch; // in-flight, m_WriteQueue  Ų
+    std::size_t m_QueuedBytes = 0;                       // m_WriteQueue
+    std::size_t m_DeferredBytes = 0;                     // m_Deferred
+    std::atomic<std::size_t> m_QueuedBytesSeen{ 0 };     // PublishQueue
+    std::atomic<std::size_t> m_QueueDepthSeen{ 0 };
+
+    //   Ʈ (strand)
+    bool m_Streaming = false;
+    bool m_Disconnected = false;
+    ObstacleImage m_Snapshot;
+    int m_SnapshotRow = 0;
+    BufferQueue m_Deferred; // Ʈ ߿  εĳƮ
+
+    // RESUME (strand)
+    bool m_Resuming = false;  //   ٸ 
+    bool m_Leaving = false;   // DESPAWN ´
+    int m_ResumeKey = 0;
+    uint32_t m_ResumeToken = 0;
+    uint32_t m_ResumeSince = 0;
+    int m_ResumeAttempts = 0;
+    boost::asio::steady_timer m_ResumeTimer;
+    boost::asio::steady_timer m_HelloTimer; // HELLO  v1 Ŭ̾Ʈ (Start)
+
+    std::size_t m_RegistrySlot = SessionRegistry::kNoSlot; // SessionRegistry  ȿ 
+
+    // Interest  ƼƼ ޽ (QueueWorld/QueueSnapshot). ƹ 忡 m_OutboxMutex ȿ
+    std::mutex m_OutboxMutex;
+    std::vector<Protocol::Message> m_Outbox;
+    bool m_DrainPosted = false;
+    std::atomic<bool> m_UdpRepeat{ false };
+    std::vector<Protocol::Message> m_Draining; // strand
+
+    struct SentMove
+    {
+        Protocol::Message move;
+        uint32_t tick;
+    };
+
+    // UDP  MOVE  ð   MOVE     
+    static constexpr double kUdpRepeatDelay = 0.25; // s
+
+    // SendDatagrams (strand)
+    std::vector<SentMove> m_UdpSent;        //  ٽ   MOVE, key 
+    std::vector<SentMove> m_UdpSentScratch; // ƽ Ҵ ʴ´
+    std::vector<Protocol::Message> m_UdpMerged;
+};
+
+// =====================================================
+// UdpChannel (definitions)
+// =====================================================
+void UdpChannel::Open(boost::asio::io_context& io, const udp::endpoint& endpoint)
+{
+    m_Socket = std::make_unique<udp::socket>(boost::asio::make_strand(io), endpoint);
+    DoReceive();
+}
+
+uint64_t UdpChannel::Register(const std::shared_ptr<Session>& session, int key)
+{
+    if (!m_Socket)
+        return 0;
+
+    //  Ű ʷ  ū     (0 "UDP ")
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    uint64_t token;
+    do
+    {
+        token = rng();
+    } while (token == 0);
+
+    std::weak_ptr<Session> weak = session;
+    boost::asio::post(m_Socket->get_executor(),
+        [this, key, token, weak]()
+        {
+            Binding& b = m_Bindings[key];
+            b = Binding{};
+            b.session = weak;
+            b.token = token;
+            m_Tokens[token] = key;
+        });
+    return token;
+}
+
+void UdpChannel::Unregister(int key)
+{
+    if (!m_Socket)
+        return;
+
+    boost::asio::post(m_Socket->get_executor(),
+        [this, key]()
+        {
+            auto it = m_Bindings.find(key);
+            if (it == m_Bindings.end())
+                return;
+            m_Tokens.erase(it->second.token);
+            m_Bindings.erase(it);
+        });
+}
+
+void UdpChannel::Rekey(int from, int to)
+{
+    if (!m_Socket)
+        return;
+
+    boost::asio::post(m_Socket->get_executor(),
+        [this, from, to]()
+        {
+            auto it = m_Bindings.find(from);
+            if (it == m_Bindings.end())
+                return;
+            Binding b = std::move(it->second);
+            m_Bindings.erase(it);
+            m_Tokens[b.token] = to;
+            m_Bindings[to] = std::move(b);
+        });
+}
+
+void UdpChannel::Send(int key, std::shared_ptr<std::string> datagram)
+{
+    if (!m_Socket)
+        return;
+
+    boost::asio::post(m_Socket->get_executor(),
+        [this, key, datagram = std::move(datagram)]() mutable
+        {
+            auto it = m_Bindings.find(key);
+            if (it != m_Bindings.end() && it->second.bound)
+                SendTo(it->second, std::move(datagram));
+        });
+}
+
+void UdpChannel::SendTo(Binding& b, std::shared_ptr<std::string> datagram)
+{
+    Protocol::PutU32(datagram->data(), ++b.sendSeq);
+    Metrics::Add(g_Metrics.Local().udpSent, 1);
+
+    //  д Ҿ datagram 
+    m_Socket->async_send_to(boost::asio::buffer(*datagram), b.peer,
+        [datagram](boost::system::error_code, std::size_t) {});
+}
+
+void UdpChannel::DoReceive()
+{
+    m_Socket->async_receive_from(boost::asio::buffer(m_RecvBuf), m_From,
+        [this](boost::system::error_code ec, std::size_t len)
+        {
+            if (ec == boost::asio::error::operation_aborted)
+                return;
+
+            // ٸ  (ICMP port unreachable )  datagram   ޴´
+            if (!ec)
+                OnDatagram(len);
+            DoReceive();
+        });
+}
+
+void UdpChannel::OnDatagram(std::size_t len)
+{
+    Metrics::ThreadMetrics& metrics = g_Metrics.Local();
+    const char* p = m_RecvBuf.data();
+
+    auto token = (len >= Protocol::kUdpClientHeader) ? m_Tokens.find(Protocol::GetU64(p)) : m_Tokens.end();
+    if (token == m_Tokens.end())
+    {
+        Metrics::Add(metrics.udpRejected, 1);
+        return;
+    }
+
+    Binding& b = m_Bindings[token->second];
+    const uint32_t seq = Protocol::GetU32(p + 8);
+    const uint8_t flags = uint8_t(p[12]);
+
+    // ʰ   / ߺ :   MOVE ̹ 
+    std::shared_ptr<Session> session = b.session.lock();
+    if (!session || (b.bound && !Protocol::SeqNewer(seq, b.recvSeq)))
+    {
+        Metrics::Add(metrics.udpRejected, 1);
+        return;
+    }
+
+    if (!b.bound)
+        g_Log.Info(LogCategory::Net, "UDP bound sessionKey=%d", token->second);
+
+    // NAT Ʈ ٲ㵵 ū  󰣴
+    b.bound = true;
+    b.recvSeq = seq;
+    b.peer = m_From;
+    Metrics::Add(metrics.udpReceived, 1);
+
+    // flags + frames (ū seq Ḷ ٸ)
+    if (g_Record.IsOpen())
+    {
+        g_Record.Append(NetLog::Kind::Datagram, session->RecordStream(),
+            p + Protocol::kUdpClientHeader - 1, len - Protocol::kUdpClientHeader + 1);
+    }
+
+    if (flags & Protocol::kUdpFlagReceiving)
+        session->SetUdpReady();
+
+    const char* frames = p + Protocol::kUdpClientHeader;
+    const std::size_t framesLen = len - Protocol::kUdpClientHeader;
+
+    // probe :  datagram ؼ  -> Ŭ̾Ʈ ΰ  ִ ˷ ش
+    if (framesLen == 0)
+    {
+        if (!(flags & Protocol::kUdpFlagReceiving))
+        {
+            auto reply = Pool::AcquireBuffer();
+            reply->assign(Protocol::kUdpServerHeader, '\0');
+            SendTo(b, std::move(reply));
+        }
+        return;
+    }
+
+    if (!Protocol::DecodeDatagram(frames, framesLen,
+        [&session](const Protocol::Message& msg) { session->ReceiveDatagram(msg); }))
+    {
+        g_Log.Warn(LogCategory::Protocol, "bad datagram, sessionKey=%d", token->second);
+    }
+}
+
+// =====================================================
+// ResumeTable (definitions)
+// =====================================================
+void ResumeTable::Start(boost::asio::io_context& io)
+{
+    m_Timer = std::make_unique<boost::asio::steady_timer>(io);
+    Schedule();
+}
+
+void ResumeTable::Schedule()
+{
+    m_Timer->expires_after(std::chrono::seconds(1));
+    m_Timer->async_wait(
+        [this](boost::system::error_code ec)
+        {
+            if (ec)
+                return;
+            Sweep();
+            Schedule();
+        });
+}
+
+uint32_t ResumeTable::Register(const std::shared_ptr<Session>& session, int key, uint32_t token)
+{
+    //  Ű ʷ  ū    
+    thread_local std::mt19937 rng(std::random_device{}());
+    while (token == 0)
+        token = rng();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Entry& e = m_Entries[key];
+    e = Entry{};
+    e.token = token;
+    e.live = session;
+    return token;
+}
+
+bool ResumeTable::Suspend(int key, const Session* session)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end() || it->second.suspended || it->second.live.lock().get() != session)
+        return false;
+
+    it->second.live.reset();
+    it->second.suspended = true;
+    it->second.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(g_ResumeWindow);
+    return true;
+}
+
+void ResumeTable::Forget(int key, const Session* session)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(key);
+    if (it != m_Entries.end() && !it->second.suspended && it->second.live.lock().get() == session)
+        m_Entries.erase(it);
+}
+
+ResumeTable::Claim ResumeTable::TryClaim(int key, uint32_t token, std::shared_ptr<Session>& live)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end() || it->second.token != token)
+        return Claim::Rejected;
+
+    if (!it->second.suspended)
+    {
+        live = it->second.live.lock();
+        return live ? Claim::Live : Claim::Rejected;
+    }
+
+    // â µ   ġ : Sweep  
+    if (std::chrono::steady_clock::now() >= it->second.deadline)
+        return Claim::Rejected;
+
+    m_Entries.erase(it);
+    return Claim::Resumed;
+}
+
+std::size_t ResumeTable::Suspended()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::size_t n = 0;
+    for (auto& [key, e] : m_Entries)
+        n += e.suspended ? 1 : 0;
+    return n;
+}
+
+void ResumeTable::Sweep()
+{
+    std::vector<int> expired;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = m_Entries.begin(); it != m_Entries.end(); )
+        {
+            if (it->second.suspended && now >= it->second.deadline)
+            {
+                expired.push_back(it->first);
+                it = m_Entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    for (int key : expired)
+    {
+        g_Log.Info(LogCategory::Net, "resume window over, removing sessionKey=%d", key);
+        RemoveBlock(key);
+    }
+}
+
+// =====================================================
+// ObstacleImage (definitions)
+// =====================================================
+int ObstacleImage::EncodeChunk(int version, int row, std::string& out) const
+{
+    if (version >= Protocol::kVersionBinary)
+        return Protocol::EncodeObstacleRows(half, row, [this](int x, int z) { return Test(x, z); }, out);
+
+    // v1 :    .    chunk ũ뿡 
+    char line[Protocol::kMaxTextLine];
+    for (; row < Rows() && out.size() < Protocol::kMaxBatchPayload; ++row)
+    {
+        const int z = row - half;
+        for (int x = -half; x <= half; )
+        {
+            if (!Test(x, z))
+            {
+                ++x;
+                continue;
+            }
+
+            const int start = x;
+            while (x <= half && Test(x, z))
+                ++x;
+
+            Protocol::Message run{ Protocol::Op::ObstacleRun, x - start, int16_t(start), int16_t(z) };
+            out.append(line, Protocol::EncodeText(run, line, true));
+        }
+    }
+    return row;
+}
+
+// =====================================================
+// Interest (definitions)
+// =====================================================
+void Interest::Join(Session* session, int key)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Watcher& w = m_Watchers[key];
+    w.session = session;
+
+    // ̹    ġ,   
+    auto vis = m_Visible.find(key);
+    w.center = (vis != m_Visible.end()) ? vis->second.bucket : BucketOf(0, 0);
+
+    // ڵ  strand (chunk ũ )
+    m_Snapshot.clear();
+    ForEachBucketAround(w.center, [&](BucketId id)
+        {
+            Bucket& b = m_Buckets[id];
+            b.m_Watchers.push_back(key);
+            for (int blockKey : b.m_Blocks)
+            {
+                const Visible& v = m_Visible[blockKey];
+                m_Snapshot.push_back(Protocol::Message{ Protocol::Op::Spawn, blockKey, int16_t(v.x), int16_t(v.z) });
+            }
+        });
+    session->QueueSnapshot(m_Snapshot, WorldVersion());
+}
+
+template <typename F>
+bool Interest::Resume(Session* session, int key, uint32_t since, F&& onJoined)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_Departures.Covers(since))
+        return false;
+
+    // ֹ  ֹ  ȿ  :    εĳƮ   ڿ ´
+    const int version = session->GetVersion();
+    const bool replayed = g_Obstacles.Replay(since, [&](const std::vector<Protocol::Message>& edits)
+        {
+            auto chunk = Pool::AcquireBuffer();
+            for (auto& e : edits)
+            {
+                AppendEncoded(e, version, *chunk);
+                if (chunk->size() >= Protocol::kMaxBatchPayload)
+                {
+                    session->Send(SharedBuffer(std::move(chunk)));
+                    chunk = Pool::AcquireBuffer();
+                }
+            }
+            if (!chunk->empty())
+                session->Send(SharedBuffer(std::move(chunk)));
+            onJoined();
+        });
+    if (!replayed)
+        return false;
+
+    Watcher& w = m_Watchers[key];
+    w.session = session;
+
+    auto vis = m_Visible.find(key);
+    w.center = (vis != m_Visible.end()) ? vis->second.bucket : BucketOf(0, 0);
+    ForEachBucketAround(w.center, [&](BucketId id) { m_Buckets[id].m_Watchers.push_back(key); });
+
+    auto seen = [&](int blockKey)
+        {
+            auto v = m_Visible.find(blockKey);
+            return v != m_Visible.end() && (blockKey == key || Covers(w.center, v->second.bucket));
+        };
+
+    // ׵  ̰   -> DESPAWN (Ŭ̾Ʈ 𸣴 key õȴ)
+    std::vector<int> gone;
+    bool recentered = false;
+    m_Departures.ForEachSince(since, [&](const Departure& d)
+        {
+            if (!d.view)
+            {
+                if (!seen(d.key))
+                    gone.push_back(d.key);
+                return;
+            }
+            if (d.key != key)
+                return;
+
+            //  AOI Ű  :  ߽ ֺ     ̰,
+            //  ̰   ٲ    Ѵ
+            recentered = true;
+            ForEachBucketAround(d.bucket, [&](BucketId id)
+                {
+                    if (Covers(w.center, id))
+                        return;
+                    auto b = m_Buckets.find(id);
+                    if (b != m_Buckets.end())
+                        gone.insert(gone.end(), b->second.m_Blocks.begin(), b->second.m_Blocks.end());
+                });
+        });
+
+    std::sort(gone.begin(), gone.end());
+    gone.erase(std::unique(gone.begin(), gone.end()), gone.end());
+    m_Snapshot.clear();
+    for (int blockKey : gone)
+        m_Snapshot.push_back(Protocol::Message{ Protocol::Op::Despawn, blockKey });
+
+    // ̴   since Ŀ ٲ  (  ׻ : Ŭ̾Ʈ   ġ ǵ)
+    ForEachBucketAround(w.center, [&](BucketId id)
+        {
+            for (int blockKey : m_Buckets[id].m_Blocks)
+            {
+                const Visible& v = m_Visible[blockKey];
+                if (recentered || blockKey == key || v.version >= since)
+                    m_Snapshot.push_back(Protocol::Message{ Protocol::Op::Spawn, blockKey, int16_t(v.x), int16_t(v.z) });
+            }
+        });
+
+    session->QueueSnapshot(m_Snapshot, WorldVersion());
+    return true;
+}
+
+void Interest::Leave(int key)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto it = m_Watchers.find(key);
+    if (it == m_Watchers.end())
+        return;
+
+    ForEachBucketAround(it->second.center, [&](BucketId id)
+        {
+            auto b = m_Buckets.find(id);
+            if (b != m_Buckets.end())
+                EraseValue(b->second.m_Watchers, key);
+        });
+
+    EraseValue(m_Touched, key);
+    EraseValue(m_Repeat, key);
+    m_Watchers.erase(it);
+}
+
+void Interest::Spawn(int key, int x, int z)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const BucketId id = BucketOf(x, z);
+    m_Visible[key] = Visible{ x, z, id, WorldVersion() };
+
+    Bucket& b = m_Buckets[id];
+    b.m_Blocks.push_back(key);
+
+    const Protocol::Message spawn{ Protocol::Op::Spawn, key, int16_t(x), int16_t(z) };
+    for (int watcherKey : b.m_Watchers)
+    {
+        if (watcherKey != key)
+            Touch(watcherKey)->events.push_back(spawn);
+    }
+
+    //   AOI  ׻ ̰,  AOI    Űܰ
+    if (m_Watchers.count(key))
+        Touch(key)->events.push_back(spawn);
+    Recenter(key, id);
+    Flush();
+}
+
+void Interest::Despawn(int key)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    auto vis = m_Visible.find(key);
+    if (vis == m_Visible.end())
+        return;
+
+    Bucket& b = m_Buckets[vis->second.bucket];
+    EraseValue(b.m_Blocks, key);
+    Depart(key, vis->second.bucket, false);
+
+    const Protocol::Message despawn{ Protocol::Op::Despawn, key };
+    for (int watcherKey : b.m_Watchers)
+        Touch(watcherKey)->events.push_back(despawn);
+
+    m_Visible.erase(vis);
+    Flush();
+}
+
+void Interest::ApplyMoves(const Protocol::Message* moves, size_t count, uint32_t tick)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // ٽ   ִ MOVE  watcher ̹ ƽ MOVE  FlushѴ (Session::SendDatagrams)
+    if (tick != 0)
+    {
+        for (int watcherKey : m_Repeat)
+        {
+            auto it = m_Watchers.find(watcherKey);
+            if (it != m_Watchers.end() && it->second.session->UdpRepeat())
+                Touch(watcherKey);
+        }
+        m_Repeat.clear();
+    }
+
+    const uint32_t version = WorldVersion();
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Protocol::Message& m = moves[i];
+
+        auto vis = m_Visible.find(m.key);
+        if (vis == m_Visible.end())
+            continue;
+
+        Visible& v = vis->second;
+        const BucketId from = v.bucket;
+        const BucketId to = BucketOf(m.x, m.z);
+        v.x = m.x;
+        v.z = m.z;
+        v.version = version;
+
+        if (from == to)
+        {
+            for (int watcherKey : m_Buckets[to].m_Watchers)
+                Touch(watcherKey)->moves.push_back(m);
+            continue;
+        }
+
+        // Ŷ 踦 
+        v.bucket = to;
+        EraseValue(m_Buckets[from].m_Blocks, m.key);
+        Depart(m.key, from, false);
+        m_Buckets[to].m_Blocks.push_back(m.key);
+
+        const Protocol::Message spawn{ Protocol::Op::Spawn, m.key, m.x, m.z };
+        const Protocol::Message despawn{ Protocol::Op::Despawn, m.key };
+
+        for (int watcherKey : m_Buckets[to].m_Watchers)
+        {
+            if (watcherKey == m.key)
+                continue;
+            Watcher* w = Touch(watcherKey);
+            if (Covers(w->center, from))
+                w->moves.push_back(m);
+            else
+                w->events.push_back(spawn);     // enter
+        }
+        for (int watcherKey : m_Buckets[from].m_Watchers)
+        {
+            if (watcherKey == m.key)
+                continue;
+            Watcher* w = Touch(watcherKey);
+            if (!Covers(w->center, to))
+                w->events.push_back(despawn);   // leave
+        }
+
+        //   MOVE ״, ֺ enter/leave
+        if (m_Watchers.count(m.key))
+            Touch(m.key)->moves.push_back(m);
+        Recenter(m.key, to);
+    }
+
+    Flush(tick);
+    if (tick != 0)
+        m_HasRepeat.store(!m_Repeat.empty(), std::memory_order_relaxed);
+}
+
+Interest::Watcher* Interest::Touch(int watcherKey)
+{
+    Watcher& w = m_Watchers[watcherKey];
+    if (!w.touched)
+    {
+        w.touched = true;
+        m_Touched.push_back(watcherKey);
+    }
+    return &w;
+}
+
+void Interest::Depart(int key, BucketId bucket, bool view)
+{
+    if (ResumeEnabled())
+        m_Departures.Push(WorldVersion(), Departure{ key, bucket, view });
+}
+
+//  AOI ߽ ű,  ̴ /  ̰   enter/leave 
+void Interest::Recenter(int watcherKey, BucketId center)
+{
+    auto it = m_Watchers.find(watcherKey);
+    if (it == m_Watchers.end() || it->second.center == center)
+        return;
+
+    Watcher& w = it->second;
+    const BucketId old = w.center;
+    w.center = center;
+    Depart(watcherKey, old, true);
+
+    ForEachBucketAround(old, [&](BucketId id)
+        {
+            if (Covers(center, id))
+                return;
+            Bucket& b = m_Buckets[id];
+            EraseValue(b.m_Watchers, watcherKey);
+            for (int blockKey : b.m_Blocks)
+            {
+                if (blockKey != watcherKey)
+                    Touch(watcherKey)->events.push_back(Protocol::Message{ Protocol::Op::Despawn, blockKey });
+            }
+        });
+
+    ForEachBucketAround(center, [&](BucketId id)
+        {
+            if (Covers(old, id))
+                return;
+            Bucket& b = m_Buckets[id];
+            b.m_Watchers.push_back(watcherKey);
+            for (int blockKey : b.m_Blocks)
+            {
+                if (blockKey == watcherKey)
+                    continue;
+                const Visible& v = m_Visible[blockKey];
+                Touch(watcherKey)->events.push_back(
+                    Protocol::Message{ Protocol::Op::Spawn, blockKey, int16_t(v.x), int16_t(v.z) });
+            }
+        });
+}
+
+// watcher outbox  outbox ѱ (ڵ  strand)
+void Interest::Flush(uint32_t tick)
+{
+    for (int watcherKey : m_Touched)
+    {
+        auto it = m_Watchers.find(watcherKey);
+        if (it == m_Watchers.end())
+            continue;
+
+        Watcher& w = it->second;
+        w.touched = false;
+        w.session->QueueWorld(w.events, tick, w.moves);
+        if (tick != 0 && w.session->UdpReady())
+            m_Repeat.push_back(watcherKey);
+
+        Metrics::Add(g_Metrics.Local().movesDelivered, w.moves.size());
+        w.events.clear();
+        w.moves.clear();
+    }
+    m_Touched.clear();
+}
+
+// =====================================================
+// SessionRegistry (definitions)
+// =====================================================
+void SessionRegistry::Add(std::shared_ptr<Session> session)
+{
+    std::unique_lock<std::shared_mutex> lock(m_Mutex);
+    session->m_RegistrySlot = m_Sessions.size();
+    m_Sessions.push_back(std::move(session));
+}
+
+void SessionRegistry::Remove(Session* session)
+{
+    if (t_Iterating > 0)
+    {
+        t_PendingRemove.push_back(session);
+        return;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_Mutex);
+    RemoveLocked(session);
+}
+
+void SessionRegistry::RemoveLocked(Session* session)
+{
+    const std::size_t slot = session->m_RegistrySlot;
+    if (slot == kNoSlot || slot >= m_Sessions.size() || m_Sessions[slot].get() != session)
+        return;
+
+    //  Ҹ   ű
+    if (slot != m_Sessions.size() - 1)
+    {
+        m_Sessions[slot] = std::move(m_Sessions.back());
+        m_Sessions[slot]->m_RegistrySlot = slot;
+    }
+    m_Sessions.pop_back();
+    session->m_RegistrySlot = kNoSlot;
+}
+
+template <typename F>
+void SessionRegistry::ForEach(F&& f)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_Mutex);
+        ++t_Iterating;
+        for (auto& s : m_Sessions)
+            f(s);
+        --t_Iterating;
+    }
+
+    if (t_Iterating == 0 && !t_PendingRemove.empty())
+    {
+        // ݹ   ⼭ Ҹ ʵ  д
+        std::vector<std::shared_ptr<Session>> keepAlive;
+        {
+            std::unique_lock<std::shared_mutex> lock(m_Mutex);
+            for (Session* s : t_PendingRemove)
+            {
+                if (s->m_RegistrySlot != kNoSlot && s->m_RegistrySlot < m_Sessions.size())
+                    keepAlive.push_back(m_Sessions[s->m_RegistrySlot]);
+                RemoveLocked(s);
+            }
+        }
+        t_PendingRemove.clear();
+    }
+}
+
+// =====================================================
+// Broadcast helper
+// =====================================================
+//     ڵϰ, Ǹ  ۸ Ѵ
+// encode : int version -> SharedBuffer
+template <typename Encode>
+void BroadcastEncoded(Encode&& encode)
+{
+    Metrics::ScopedTimer timer(g_Metrics.Local().fanout[size_t(Metrics::Fanout::Broadcast)]);
+    SharedBuffer encoded[Protocol::kVersionLatest + 1];
+
+    g_Sessions.ForEach([&](const std::shared_ptr<Session>& s)
+        {
+            if (!s->IsJoined())
+                return;
+
+            const int version = s->GetVersion();
+            if (!encoded[version])
+                encoded[version] = encode(version);
+
+            s->Send(encoded[version]);
+        });
+}
+
+void Broadcast(const Protocol::Message& msg)
+{
+    BroadcastEncoded([&](int version) { return EncodeShared(msg, version); });
+}
+
+// =====================================================
+// Tick : MOVE ƽ ٲ ϸ Ƽ Ǵ Ŷ ϳ  (Interest Ǻ )
+// =====================================================
+class TickLoop
+{
+public:
+    TickLoop(boost::asio::io_context& io, int rate)
+        : m_Timer(io)
+        , m_Period(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / rate)))
+    {
+    }
+
+    void Start()
+    {
+        m_Next = std::chrono::steady_clock::now() + m_Period;
+        Schedule();
+    }
+
+private:
+    void Schedule()
+    {
+        m_Timer.expires_at(m_Next);
+        m_Timer.async_wait(
+            [this](boost::system::error_code ec)
+            {
+                if (ec)
+                    return;
+
+                Tick();
+
+                //  . и ƽ Ƽ  ʰ ǳʶڴ
+                m_Next += m_Period;
+                auto now = std::chrono::steady_clock::now();
+                if (m_Next < now)
+                    m_Next = now + m_Period;
+
+                Schedule();
+            });
+    }
+
+    void Tick()
+    {
+        const auto start = std::chrono::steady_clock::now();
+        m_Moves.clear();
+
+        for (auto& shard : g_Blocks)
+        {
+            std::lock_guard<std::mutex> lock(shard.m_Mutex);
+            for (int key : shard.m_Dirty)
+            {
+                auto it = shard.m_Blocks.find(key);
+                if (it == shard.m_Blocks.end())
+                    continue; // ƽ ̿  
+
+                Block& b = it->second;
+                b.dirty = false;
+                m_Moves.push_back(Protocol::Message{ Protocol::Op::Move, b.key, int16_t(b.x), int16_t(b.z) });
+            }
+            shard.m_Dirty.clear();
+        }
+
+        if (m_Moves.empty() && !g_Interest.HasRepeat())
+            return;
+
+        // ġ Ű ̰ ڵϹǷ  ʿ
+        std::sort(m_Moves.begin(), m_Moves.end(),
+            [](const Protocol::Message& a, const Protocol::Message& b) { return a.key < b.key; });
+
+        // ƽ ȣ ۺ  ð  (ǳʶ ƽ ) -> tick / rate =  ð,  
+        const uint32_t tick = WorldVersion();
+
+        // AOI ͸  Ǻ ġ ϳ
+        g_Interest.ApplyMoves(m_Moves.data(), m_Moves.size(), tick);
+
+        //  ƽ  ʴ´ (fan-out 븸)
+        g_Metrics.Local().fanout[size_t(Metrics::Fanout::Tick)].Observe(std::chrono::steady_clock::now() - start);
+    }
+
+private:
+    boost::asio::steady_timer m_Timer;
+    std::chrono::steady_clock::duration m_Period;
+    std::chrono::steady_clock::time_point m_Next;
+    std::vector<Protocol::Message> m_Moves; // ƽ ڵ鷯  (Ÿ̸ ü̶ )
+};
+
+// =====================================================
+// Accept loop
+// =====================================================
+void DoAccept(tcp::acceptor& acceptor)
+{
+    // Ǹ strand ϳ :  executor strand
+    // б/ ڵ鷯 Send post  ȭȴ.
+    acceptor.async_accept(
+        boost::asio::make_strand(acceptor.get_executor()),
+        [&](boost::system::error_code ec, tcp::socket socket)
+        {
+            if (!ec)
+            {
+                // g_NextSessionKey m_SessionKey  𸣰ڴ.  ߿ Ϻε.
+                g_Log.Info(LogCategory::Net, "CONNECT sessionKey=%d", g_NextSessionKey.load());
+                // Session + control block Ǯ  ϳ ( Ƶ Ҵ⸦  ź)
+                auto session = std::allocate_shared<Session>(
+                    Pool::Allocator<Session, Pool::SessionTag>{}, std::move(socket));
+                g_Sessions.Add(session);
+                session->Start();
+            }
+            DoAccept(acceptor);
+        });
+}
+
+// =====================================================
+// Metrics endpoint : GET /metrics -> Prometheus text format
+//  Ʈ . û ϳ  ϳ, ׸ ݴ´
+// =====================================================
+void RenderMetrics(std::string& out)
+{
+    g_Metrics.Render(out);
+
+    struct QueueInfo { std::size_t bytes, depth; int key; };
+    std::vector<QueueInfo> queues;
+    std::size_t joined = 0, totalBytes = 0;
+
+    g_Sessions.ForEach([&](const std::shared_ptr<Session>& s)
+        {
+            joined += s->IsJoined() ? 1 : 0;
+            totalBytes += s->QueuedBytes();
+            queues.push_back(QueueInfo{ s->QueuedBytes(), s->QueueDepth(), s->SessionKey() });
+        });
+
+    using Metrics::Registry;
+    Registry::Header(out, "netbox_sessions", "gauge", "Connected sessions");
+    Registry::Sample(out, "netbox_sessions", nullptr, nullptr, double(queues.size()));
+    Registry::Header(out, "netbox_sessions_joined", "gauge", "Sessions past the join snapshot");
+    Registry::Sample(out, "netbox_sessions_joined", nullptr, nullptr, double(joined));
+    Registry::Header(out, "netbox_sessions_suspended", "gauge", "Disconnected sessions whose block waits for a RESUME");
+    Registry::Sample(out, "netbox_sessions_suspended", nullptr, nullptr, double(g_Resume.Suspended()));
+
+    Registry::Header(out, "netbox_write_queue_limit_bytes", "gauge", "--write-queue-limit (0 = unlimited)");
+    Registry::Sample(out, "netbox_write_queue_limit_bytes", nullptr, nullptr, double(g_WriteQueueLimit));
+    Registry::Header(out, "netbox_write_queue_bytes", "gauge", "Bytes queued for write, all sessions");
+    Registry::Sample(out, "netbox_write_queue_bytes", nullptr, nullptr, double(totalBytes));
+
+    // Ǻ ť ū    ( ŭ ð迭  ʴ´)
+    constexpr std::size_t kTopSessions = 16;
+    const std::size_t top = (std::min)(kTopSessions, queues.size());
+    std::partial_sort(queues.begin(), queues.begin() + top, queues.end(),
+        [](const QueueInfo& a, const QueueInfo& b) { return a.bytes > b.bytes; });
+
+    Registry::Header(out, "netbox_pool_heap_allocations_total", "counter",
+        "Pool misses that went to the heap (flat in steady state)");
+    Registry::Sample(out, "netbox_pool_heap_allocations_total", "pool", "session",
+        double(Pool::Stats<Pool::SessionTag>().heap.load(std::memory_order_relaxed)));
+    Registry::Sample(out, "netbox_pool_heap_allocations_total", "pool", "recv",
+        double(Pool::Stats<Pool::RecvTag>().heap.load(std::memory_order_relaxed)));
+    Registry::Sample(out, "netbox_pool_heap_allocations_total", "pool", "buffer",
+        double(Pool::Stats<Pool::BufferTag>().heap.load(std::memory_order_relaxed)));
+    Registry::Sample(out, "netbox_pool_heap_allocations_total", "pool", "buffer_control",
+        double(Pool::Stats<Pool::ControlTag>().heap.load(std::memory_order_relaxed)));
+
+    Registry::Header(out, "netbox_buffer_grown_total", "counter", "Pooled buffers whose string had to grow while being filled");
+    Registry::Sample(out, "netbox_buffer_grown_total", nullptr, nullptr,
+        double(Pool::BufferStats().grown.load(std::memory_order_relaxed)));
+    Registry::Header(out, "netbox_buffer_discarded_total", "counter", "Buffers over the kept capacity, freed instead of pooled");
+    Registry::Sample(out, "netbox_buffer_discarded_total", nullptr, nullptr,
+        double(Pool::BufferStats().discarded.load(std::memory_order_relaxed)));
+
+    Registry::Header(out, "netbox_session_write_queue_bytes", "gauge", "Bytes queued for the sessions with the largest queues");
+    for (std::size_t i = 0; i < top; ++i)
+        Registry::Sample(out, "netbox_session_write_queue_bytes", "session", std::to_string(queues[i].key).c_str(), double(queues[i].bytes));
+    Registry::Header(out, "netbox_session_write_queue_depth", "gauge", "Buffers queued for the sessions with the largest queues");
+    for (std::size_t i = 0; i < top; ++i)
+        Registry::Sample(out, "netbox_session_write_queue_depth", "session", std::to_string(queues[i].key).c_str(), double(queues[i].depth));
+}
+
+class MetricsConnection : public std::enable_shared_from_this<MetricsConnection>
+{
+public:
+    explicit MetricsConnection(tcp::socket socket)
+        : m_Socket(std::move(socket))
+        , m_Request(8 * 1024) //  
+    {
+    }
+
+    void Start()
+    {
+        auto self = shared_from_this();
+        boost::asio::async_read_until(m_Socket, m_Request, "\r\n\r\n",
+            [this, self](boost::system::error_code ec, std::size_t)
+            {
+                if (ec)
+                    return;
+
+                std::string line;
+                std::istream request(&m_Request);
+                std::getline(request, line);
+
+                const bool ok = line.rfind("GET /metrics", 0) == 0 || line.rfind("GET / ", 0) == 0;
+                std::string body;
+                if (ok)
+                    RenderMetrics(body);
+                else
+                    body = "not found\n";
+
+                m_Response = std::string(ok ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 404 Not Found\r\n")
+                    + "Content-Type: text/plain; version=0.0.4\r\n"
+                    + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                    + "Connection: close\r\n\r\n" + body;
+
+                boost::asio::async_write(m_Socket, boost::asio::buffer(m_Response),
+                    [this, self](boost::system::error_code, std::size_t)
+                    {
+                        boost::system::error_code ignored;
+                        m_Socket.shutdown(tcp::socket::shutdown_both, ignored);
+                    });
+            });
+    }
+
+private:
+    tcp::socket m_Socket;
+    boost::asio::streambuf m_Request;
+    std::string m_Response;
+};
+
+void DoAcceptMetrics(tcp::acceptor& acceptor)
+{
+    acceptor.async_accept(
+        boost::asio::make_strand(acceptor.get_executor()),
+        [&](boost::system::error_code ec, tcp::socket socket)
+        {
+            if (!ec)
+                std::make_shared<MetricsConnection>(std::move(socket))->Start();
+            DoAcceptMetrics(acceptor);
+        });
+}
+
+// =====================================================
+// Replay (--replay <log>)
+// --record    ٽ  ޾Ҵ Ʈ ״  :
+// б -> Ľ -> HandleCommand -> ƽ fan-out   ״  (Ŭ̾Ʈ ).
+// ⺻ ִ ӵ ( Ͽ   Ʈ kMaxInFlight  ٸ),
+// --replay-pace original̸ ϵ ð .    о .
+// ϵ datagram MOVE    TCP Ʈ,   迡 
+//  : UDPó Ҿų κ       
+//    óȴ (UdpChannel  δ Ÿ ʴ´).
+// RESUME  key / ū       ȴ.
+//   ݰ   Ǳ DISCONNECTϸ ó  onDone
+// =====================================================
+class Replay : public std::enable_shared_from_this<Replay>
+{
+public:
+    Replay(boost::asio::io_context& io, tcp::endpoint server, bool paced, std::function<void()> onDone)
+        : m_IO(io)
+        , m_Server(server)
+        , m_Timer(io)
+        , m_Paced(paced)
+        , m_OnDone(std::move(onDone))
+    {
+    }
+
+    bool Open(const std::string& file) { return m_Log.Open(file); }
+
+    void Start()
+    {
+        m_Messages = TotalMessages();
+        m_Start = std::chrono::steady_clock::now();
+        Step();
+    }
+
+private:
+    static constexpr std::size_t kMaxInFlight = 1024 * 1024;
+    static constexpr auto kDrainPoll = std::chrono::milliseconds(5);
+
+    //  Ʈ ؽƮ  / ̳ʸ   Գ (Session::DoRead  Ģ :
+    // HELLO 2 ̻ Ǵ RESUME   ̳ʸ)
+    struct Cursor
+    {
+        bool binary = false;
+        std::string line;        // ؽƮ :   պκ
+        std::size_t header = 0;  // ̳ʸ :    Ʈ   ó
+        char len[2] = {};
+        std::size_t body = 0;    //  
+
+        bool AtFrameBoundary() const { return binary && header == 0; }
+
+        // nƮ . stop̸ ó  迡 .  Ʈ 
+        std::size_t Feed(const char* p, std::size_t n, bool stop)
+        {
+            std::size_t i = 0;
+            while (i < n && !(stop && i > 0 && AtFrameBoundary()))
+            {
+                if (!binary)
+                {
+                    const char ch = p[i++];
+                    if (ch != '\n')
+                    {
+                        if (line.size() < Protocol::kMaxTextLine)
+                            line += ch;
+                        continue;
+                    }
+                    int version = 0;
+                    if (line.rfind("HELLO ", 0) == 0)
+                        version = std::atoi(line.c_str() + 6);
+                    else if (line.rfind("RESUME ", 0) == 0)
+                        version = Protocol::kVersionResume;
+                    binary = (version >= Protocol::kVersionBinary);
+                    line.clear();
+                }
+                else if (header < sizeof(len))
+                {
+                    len[header++] = p[i++];
+                    if (header == sizeof(len))
+                        body = Protocol::GetU16(len);
+                }
+                else
+                {
+                    const std::size_t take = (std::min)(body, n - i);
+                    i += take;
+                    body -= take;
+                }
+
+                if (header == sizeof(len) && body == 0)
+                    header = 0; //  
+            }
+            return i;
+        }
+    };
+
+    struct Connection
+    {
+        explicit Connection(boost::asio::io_context& io) : socket(io) {}
+
+        tcp::socket socket;
+        std::array<char, 16 * 1024> in;                //    ()
+        Cursor cursor;
+        std::deque<boost::asio::const_buffer> queue;   //    Ų ( )
+        std::vector<boost::asio::const_buffer> batch;  // in-flight
+        std::vector<boost::asio::const_buffer> held;   //  踦 ٸ datagram 
+        bool closing = false;                          // ť   shutdown(send)
+    };
+    using ConnectionPtr = std::shared_ptr<Connection>;
+
+    static uint64_t TotalMessages()
+    {
+        uint64_t total = 0;
+        for (std::size_t op = 0; op < Metrics::kOpSlots; ++op)
+            total += g_Metrics.Sum([op](Metrics::ThreadMetrics& t) -> auto& { return t.received[op]; });
+        return total;
+    }
+
+    //  ڵ尡 ٸ  (ð / in-flight) 
+    void Step()
+    {
+        while (m_InFlight < kMaxInFlight)
+        {
+            if (!m_HasNext && !(m_HasNext = m_Log.Next(m_Next)))
+            {
+                Drain();
+                return;
+            }
+
+            if (m_Paced)
+            {
+                // ù ڵ  ( ϰ ù   ð ǳʶڴ)
+                if (m_Records == 0)
+                    m_FirstNs = m_Next.timeNs;
+                const auto due = m_Start + std::chrono::nanoseconds(m_Next.timeNs - m_FirstNs);
+                if (due > std::chrono::steady_clock::now())
+                {
+                    auto self = shared_from_this();
+                    m_Timer.expires_at(due);
+                    m_Timer.async_wait([this, self](boost::system::error_code ec) { if (!ec) Step(); });
+                    return;
+                }
+            }
+
+            Issue(m_Next);
+            m_HasNext = false;
+        }
+        m_Blocked = true; // Ⱑ  ٽ Step
+    }
+
+    void Issue(const NetLog::Record& r)
+    {
+        ++m_Records;
+        switch (r.kind)
+        {
+        case NetLog::Kind::Open:
+        {
+            auto c = std::make_shared<Connection>(m_IO);
+            boost::system::error_code ec;
+            c->socket.connect(m_Server, ec); //  : accept ť ٷ 
+            if (ec)
+            {
+                g_Log.Warn(LogCategory::Server, "REPLAY connect failed: %s", ec.message().c_str());
+                return;
+            }
+            c->socket.set_option(tcp::no_delay(true), ec);
+            m_Connections[r.stream] = c;
+            ++m_Opened;
+            Read(c);
+            break;
+        }
+
+        case NetLog::Kind::Data:
+            if (auto c = Find(r.stream))
+                SendBytes(c, r.data, r.size);
+            break;
+
+        case NetLog::Kind::Datagram:
+            // flags  .   probe / keepalive
+            if (auto c = Find(r.stream); c && r.size > 1)
+            {
+                ++m_Datagrams;
+                const auto frames = boost::asio::buffer(r.data + 1, r.size - 1);
+                if (c->held.empty() && c->cursor.AtFrameBoundary())
+                    Enqueue(c, frames);
+                else
+                    c->held.push_back(frames);
+            }
+            break;
+
+        case NetLog::Kind::Close:
+            if (auto c = Find(r.stream))
+            {
+                c->closing = true;
+                if (c->batch.empty() && c->queue.empty())
+                    Shutdown(*c);
+                m_Connections.erase(r.stream);
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    ConnectionPtr Find(uint32_t stream)
+    {
+        auto it = m_Connections.find(stream);
+        return (it != m_Connections.end()) ? it->second : nullptr;
+    }
+
+    // ٸ datagram   ù  迡   ڸ ִ´
+    void SendBytes(const ConnectionPtr& c, const char* p, std::size_t n)
+    {
+        while (!c->held.empty() && n > 0)
+        {
+            const std::size_t used = c->cursor.Feed(p, n, true);
+            Enqueue(c, boost::asio::buffer(p, used));
+            p += used;
+            n -= used;
+            if (c->cursor.AtFrameBoundary())
+            {
+                for (const auto& frames : c->held)
+                    Enqueue(c, frames);
+                c->held.clear();
+            }
+        }
+
+        if (n > 0)
+        {
+            c->cursor.Feed(p, n, false);
+            Enqueue(c, boost::asio::buffer(p, n));
+        }
+    }
+
+    void Enqueue(const ConnectionPtr& c, boost::asio::const_buffer buf)
+    {
+        if (buf.size() == 0)
+            return;
+        c->queue.push_back(buf);
+        m_InFlight += buf.size();
+        m_Bytes += buf.size();
+        if (c->batch.empty())
+            Write(c);
+    }
+
+    void Write(const ConnectionPtr& c)
+    {
+        std::size_t bytes = 0;
+        c->batch.assign(c->queue.begin(), c->queue.end());
+        for (const auto& b : c->batch)
+            bytes += b.size();
+
+        auto self = shared_from_this();
+        boost::asio::async_write(c->socket, c->batch,
+            [this, self, c, bytes](boost::system::error_code ec, std::size_t)
+            {
+                m_InFlight -= bytes;
+                c->queue.erase(c->queue.begin(), c->queue.begin() + c->batch.size());
+                c->batch.clear();
+
+                if (ec)
+                {
+                    //   (slow consumer ) :   
+                    for (const auto& b : c->queue)
+                        m_InFlight -= b.size();
+                    c->queue.clear();
+                }
+                else if (!c->queue.empty())
+                {
+                    Write(c);
+                }
+                else if (c->closing)
+                {
+                    Shutdown(*c);
+                }
+
+                if (m_Blocked && m_InFlight < kMaxInFlight)
+                {
+                    m_Blocked = false;
+                    Step();
+                }
+            });
+    }
+
+    //   бⰡ EOF -> OnDisconnect
+    static void Shutdown(Connection& c)
+    {
+        boost::system::error_code ignored;
+        c.socket.shutdown(tcp::socket::shutdown_send, ignored);
+    }
+
+    void Read(const ConnectionPtr& c)
+    {
+        auto self = shared_from_this();
+        c->socket.async_read_some(boost::asio::buffer(c->in),
+            [this, self, c](boost::system::error_code ec, std::size_t)
+            {
+                if (!ec)
+                    Read(c);
+            });
+    }
+
+    //   :   ݰ   ó 
+    void Drain()
+    {
+        if (!m_Draining)
+        {
+            m_Draining = true;
+            for (auto& [stream, c] : m_Connections)
+            {
+                c->closing = true;
+                if (c->batch.empty() && c->queue.empty())
+                    Shutdown(*c);
+            }
+            m_Connections.clear();
+        }
+
+        if (m_InFlight > 0 || g_Sessions.Size() > 0)
+        {
+            auto self = shared_from_this();
+            m_Timer.expires_after(kDrainPoll);
+            m_Timer.async_wait([this, self](boost::system::error_code ec) { if (!ec) Drain(); });
+            return;
+        }
+
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count();
+        const uint64_t messages = TotalMessages() - m_Messages;
+        g_Log.Info(LogCategory::Server,
+            "REPLAY done (%s) : %llu records, %llu connections, %llu datagrams inlined, %.2f MB",
+            m_Paced ? "original pace" : "max", (unsigned long long)m_Records, (unsigned long long)m_Opened,
+            (unsigned long long)m_Datagrams, double(m_Bytes) / (1024.0 * 1024.0));
+        g_Log.Info(LogCategory::Server,
+            "REPLAY %llu messages handled in %.3f s : %.0f msg/s, %.2f MB/s",
+            (unsigned long long)messages, seconds, double(messages) / seconds,
+            double(m_Bytes) / (1024.0 * 1024.0) / seconds);
+        m_OnDone();
+    }
+
+    boost::asio::io_context& m_IO;
+    tcp::endpoint m_Server;
+    boost::asio::steady_timer m_Timer; // pacing / drain
+    bool m_Paced;
+    std::function<void()> m_OnDone;
+
+    NetLog::Reader m_Log;
+    NetLog::Record m_Next;
+    bool m_HasNext = false;
+    bool m_Blocked = false;  // in-flight    ϷḦ ٸ
+    bool m_Draining = false;
+    std::unordered_map<uint32_t, ConnectionPtr> m_Connections; //  stream ->  ִ 
+    std::size_t m_InFlight = 0;
+
+    std::chrono::steady_clock::time_point m_Start;
+    uint64_t m_FirstNs = 0;
+    uint64_t m_Messages = 0; //   HandleCommand 
+    uint64_t m_Records = 0;
+    uint64_t m_Opened = 0;
+    uint64_t m_Bytes = 0;
+    uint64_t m_Datagrams = 0;
+};
+
+// =====================================================
+// main
+// =====================================================
+int main(int argc, char* argv[])
+{
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string opt = argv[i];
+        if (opt == "--write-batch")
+            g_WriteBatchLimit = std::max<std::size_t>(1, std::strtoul(argv[i + 1], nullptr, 10));
+        else if (opt == "--threads")
+            g_ThreadCount = std::atoi(argv[i + 1]);
+        else if (opt == "--tick-rate")
+            g_TickRate = std::atoi(argv[i + 1]);
+        else if (opt == "--aoi-bucket")
+            g_AoiBucketCells = std::max(1, std::atoi(argv[i + 1]));
+        else if (opt == "--aoi-radius")
+            g_AoiRadius = std::max(0, std::atoi(argv[i + 1]));
+        else if (opt == "--write-queue-limit")
+            g_WriteQueueLimit = std::strtoul(argv[i + 1], nullptr, 10);
+        else if (opt == "--world-half")
+            g_WorldHalfCells = std::clamp(std::atoi(argv[i + 1]), 1, Protocol::kMaxObstacleHalf);
+        else if (opt == "--udp-port")
+            g_UdpPort = uint16_t(std::clamp(std::atoi(argv[i + 1]), 0, 65535));
+        else if (opt == "--resume-window")
+            g_ResumeWindow = std::max(0, std::atoi(argv[i + 1]));
+        else if (opt == "--metrics-port")
+            g_MetricsPort = uint16_t(std::clamp(std::atoi(argv[i + 1]), 0, 65535));
+        else if (opt == "--log-level")
+            g_Log.SetLevel(std::string_view(argv[i + 1]));
+        else if (opt == "--log-rate")
+            g_Log.SetRate(argv[i + 1]);   // move=100, all=0 (ʴ  , 0 =  )
+        else if (opt == "--log-sample")
+            g_Log.SetSample(argv[i + 1]); // move=10 (10ٿ 1)
+        else if (opt == "--record")
+            g_RecordFile = argv[i + 1];
+        else if (opt == "--replay")
+            g_ReplayFile = argv[i + 1];
+        else if (opt == "--replay-pace")
+            g_ReplayPaced = (std::string_view(argv[i + 1]) == "original");
+    }
+
+    g_Log.Start();
+
+    // 0  = ھ 
+    if (g_ThreadCount <= 0)
+        g_ThreadCount = std::max(1, int(std::thread::hardware_concurrency()));
+
+    g_Obstacles.Init(g_WorldHalfCells);
+
+    if (g_TickRate > 0)
+    {
+        g_TickPeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / g_TickRate));
+    }
+
+    try
+    {
+        boost::asio::io_context io;
+        //const auto address = boost::asio::ip::address(boost::asio::ip::address_v4::any());
+        const auto address = boost::asio::ip::make_address("172.21.1.35");//
+        tcp::acceptor acceptor(io, tcp::endpoint(address, 8080));
+
+        g_Log.Info(LogCategory::Server, "Server started on port 8080 (%d threads, %d Hz tick)",
+            g_ThreadCount, g_TickRate);
+        g_WorldStart = std::chrono::steady_clock::now();
+        DoAccept(acceptor);
+
+        if (ResumeEnabled())
+        {
+            g_Resume.Start(io);
+            g_Log.Info(LogCategory::Server, "RESUME window %d s", g_ResumeWindow);
+        }
+
+        if (g_UdpPort != 0)
+        {
+            g_Udp.Open(io, udp::endpoint(address, g_UdpPort));
+            g_Log.Info(LogCategory::Server, "UDP on port %d (MOVE)", int(g_UdpPort));
+        }
+
+        std::unique_ptr<tcp::acceptor> metricsAcceptor;
+        if (g_MetricsPort != 0)
+        {
+            metricsAcceptor = std::make_unique<tcp::acceptor>(io, tcp::endpoint(address, g_MetricsPort));
+            DoAcceptMetrics(*metricsAcceptor);
+            g_Log.Info(LogCategory::Server, "Metrics on port %d (/metrics)", int(g_MetricsPort));
+        }
+
+        std::unique_ptr<TickLoop> tick;
+        if (g_TickRate > 0)
+        {
+            tick = std::make_unique<TickLoop>(io, g_TickRate);
+            tick->Start();
+        }
+
+        if (!g_RecordFile.empty())
+        {
+            if (g_Record.Open(g_RecordFile))
+                g_Log.Info(LogCategory::Server, "Recording received bytes to %s (Ctrl+C to stop)", g_RecordFile.c_str());
+            else
+                g_Log.Error(LogCategory::Server, "--record: cannot create %s", g_RecordFile.c_str());
+        }
+
+        //  ̸ Ctrl+C io ߰   ̷ ݴ´ (׳ ׾  ڵ )
+        boost::asio::signal_set signals(io);
+        if (g_Record.IsOpen())
+        {
+            signals.add(SIGINT);
+            signals.add(SIGTERM);
+            signals.async_wait([&io](boost::system::error_code ec, int) { if (!ec) io.stop(); });
+        }
+
+        //    ϳ :    io 带  ʴ´
+        boost::asio::io_context replayIo;
+        std::thread replayThread;
+        if (!g_ReplayFile.empty())
+        {
+            auto replay = std::make_shared<Replay>(replayIo, acceptor.local_endpoint(),
+                g_ReplayPaced, [&io]() { io.stop(); });
+            if (replay->Open(g_ReplayFile))
+            {
+                g_Log.Info(LogCategory::Server, "REPLAY %s (%s)", g_ReplayFile.c_str(), g_ReplayPaced ? "original pace" : "max");
+                boost::asio::post(replayIo, [replay]() { replay->Start(); });
+                replayThread = std::thread([&replayIo]() { replayIo.run(); });
+            }
+            else
+            {
+                g_Log.Error(LogCategory::Server, "--replay: cannot read %s", g_ReplayFile.c_str());
+            }
+        }
+
+        std::vector<std::thread> workers;
+        for (int i = 1; i < g_ThreadCount; ++i)
+            workers.emplace_back([&io]() { io.run(); });
+
+        io.run();
+
+        for (auto& t : workers)
+            t.join();
+
+        replayIo.stop();
+        if (replayThread.joinable())
+            replayThread.join();
+        g_Record.Close();
     }
     catch (const std::exception& e)
     {
-        std::cerr << "Server exception: " << e.what() << "\n";
+        g_Log.Error(LogCategory::Server, "Server exception: %s", e.what());
     }
 
     return 0;
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include <boost/asio/buffer.hpp>
+
+// =====================================================
+// BufferSequenceView (shared by Server and D3DBoxApp)
+//
+// async_write copies its buffer sequence into the operation. Handing it a
+// std::vector<const_buffer> therefore allocates a new vector on every
+// gathered write. This view holds only a pointer to the caller's vector,
+// so the copy is one word. The vector must not change until the write
+// completes (the in-flight batch is a member that DoWrite refills only
+// after the previous write's handler ran).
+// =====================================================
+class BufferSequenceView
+{
+public:
+    using value_type = boost::asio::const_buffer;
+    using const_iterator = std::vector<boost::asio::const_buffer>::const_iterator;
+
+    explicit BufferSequenceView(const std::vector<boost::asio::const_buffer>& buffers)
+        : m_Buffers(&buffers)
+    {
+    }
+
+    const_iterator begin() const { return m_Buffers->begin(); }
+    const_iterator end() const { return m_Buffers->end(); }
+
+private:
+    const std::vector<boost::asio::const_buffer>* m_Buffers;
+};
@@ -0,0 +1,319 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include "Protocol.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// =====================================================
+// NetLog : received bytes, recorded for replay (server --record, client --record)
+//
+// Append-only binary file, written through a memory mapping : Append is a
+// memcpy under a mutex, no syscall. The file grows kGrow at a time (remap)
+// and is cut to its real length on Close. A record is never split, so a
+// log left behind by a crash reads fine up to the last record (the zero
+// filled tail reads as the end).
+//
+//   file   : "NBOXLOG1"  u32 version  u32 0
+//   record : u32 size  u8 kind  u8 0 u8 0 u8 0  u32 stream  u64 timeNs  bytes[size]
+//            back to back, no padding : fields are read byte by byte
+//            (Protocol::GetU32/GetU64), so alignment buys nothing.
+//            timeNs counts from Open, little endian
+//
+// stream is whoever received the bytes : the server's connection id, the
+// client's connection number. Data is a socket read exactly as it came
+// (text lines and frames may be cut anywhere), Datagram one UDP payload.
+// =====================================================
+namespace NetLog
+{
+    enum class Kind : uint8_t
+    {
+        End = 0,  // zero filled tail
+        Open,     // connection accepted / connected
+        Data,     // TCP bytes
+        Datagram, // UDP payload
+        Close,
+    };
+
+    constexpr char kMagic[8] = { 'N', 'B', 'O', 'X', 'L', 'O', 'G', '1' };
+    constexpr uint32_t kVersion = 2; // 1 : 레코드 뒤를 8바이트로 채웠다
+    constexpr size_t kFileHeader = 16;
+    constexpr size_t kRecordHeader = 20;
+
+    struct Record
+    {
+        Kind        kind = Kind::End;
+        uint32_t    stream = 0;
+        uint64_t    timeNs = 0;
+        const char* data = nullptr;
+        uint32_t    size = 0;
+    };
+
+    // -------------------------
+    // platform : one read-write or read-only mapping of a whole file
+    // -------------------------
+    class Mapping
+    {
+    public:
+        Mapping() = default;
+        ~Mapping() { Close(); }
+
+        Mapping(const Mapping&) = delete;
+        Mapping& operator=(const Mapping&) = delete;
+
+        bool Create(const std::filesystem::path& path)
+        {
+#ifdef _WIN32
+            m_File = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+            return m_File != INVALID_HANDLE_VALUE;
+#else
+            m_File = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+            return m_File >= 0;
+#endif
+        }
+
+        bool OpenRead(const std::filesystem::path& path)
+        {
+#ifdef _WIN32
+            m_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            LARGE_INTEGER size{};
+            if (m_File == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+                return false;
+            m_Map = CreateFileMappingW(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            m_Base = m_Map ? static_cast<char*>(MapViewOfFile(m_Map, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+            m_Size = size_t(size.QuadPart);
+#else
+            m_File = ::open(path.c_str(), O_RDONLY);
+            struct stat st {};
+            if (m_File < 0 || fstat(m_File, &st) != 0 || st.st_size == 0)
+                return false;
+            void* p = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, m_File, 0);
+            m_Base = (p == MAP_FAILED) ? nullptr : static_cast<char*>(p);
+            m_Size = size_t(st.st_size);
+#endif
+            return m_Base != nullptr;
+        }
+
+        // 파일을 size로 늘리고 (새 자리는 0) 다시 매핑한다
+        bool Resize(size_t size)
+        {
+            Unmap();
+#ifdef _WIN32
+            LARGE_INTEGER li{};
+            li.QuadPart = LONGLONG(size);
+            if (!SetFilePointerEx(m_File, li, nullptr, FILE_BEGIN) || !SetEndOfFile(m_File))
+                return false;
+            m_Map = CreateFileMappingW(m_File, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+            m_Base = m_Map ? static_cast<char*>(MapViewOfFile(m_Map, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+#else
+            if (ftruncate(m_File, off_t(size)) != 0)
+                return false;
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_File, 0);
+            m_Base = (p == MAP_FAILED) ? nullptr : static_cast<char*>(p);
+#endif
+            m_Size = m_Base ? size : 0;
+            return m_Base != nullptr;
+        }
+
+        // length까지 자르고 닫는다 (length == 0 : 크기는 그대로)
+        void Close(size_t length = 0)
+        {
+            Unmap();
+#ifdef _WIN32
+            if (m_File != INVALID_HANDLE_VALUE)
+            {
+                if (length > 0)
+                {
+                    LARGE_INTEGER li{};
+                    li.QuadPart = LONGLONG(length);
+                    SetFilePointerEx(m_File, li, nullptr, FILE_BEGIN);
+                    SetEndOfFile(m_File);
+                }
+                CloseHandle(m_File);
+                m_File = INVALID_HANDLE_VALUE;
+            }
+#else
+            if (m_File >= 0)
+            {
+                if (length > 0 && ftruncate(m_File, off_t(length)) != 0)
+                    std::perror("NetLog: ftruncate");
+                ::close(m_File);
+                m_File = -1;
+            }
+#endif
+        }
+
+        char* Data() const { return m_Base; }
+        size_t Size() const { return m_Size; }
+
+    private:
+        void Unmap()
+        {
+#ifdef _WIN32
+            if (m_Base)
+                UnmapViewOfFile(m_Base);
+            if (m_Map)
+                CloseHandle(m_Map);
+            m_Map = nullptr;
+#else
+            if (m_Base)
+                munmap(m_Base, m_Size);
+#endif
+            m_Base = nullptr;
+            m_Size = 0;
+        }
+
+#ifdef _WIN32
+        HANDLE m_File = INVALID_HANDLE_VALUE;
+        HANDLE m_Map = nullptr;
+#else
+        int m_File = -1;
+#endif
+        char* m_Base = nullptr;
+        size_t m_Size = 0;
+    };
+
+    // -------------------------
+    // Writer (아무 스레드에서나)
+    // -------------------------
+    class Writer
+    {
+    public:
+        static constexpr size_t kGrow = 64 * 1024 * 1024;
+
+        ~Writer() { Close(); }
+
+        bool Open(const std::filesystem::path& path)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (!m_Map.Create(path) || !m_Map.Resize(kGrow))
+            {
+                m_Map.Close();
+                return false;
+            }
+
+            std::memcpy(m_Map.Data(), kMagic, sizeof(kMagic));
+            Protocol::PutU32(m_Map.Data() + 8, kVersion);
+            m_Used = kFileHeader;
+            m_Start = std::chrono::steady_clock::now();
+            m_Open.store(true, std::memory_order_release);
+            return true;
+        }
+
+        // 기록 중인가 (꺼져 있으면 Append를 부르지 않는다 : 락도 없이 한 번의 load)
+        bool IsOpen() const { return m_Open.load(std::memory_order_acquire); }
+
+        void Append(Kind kind, uint32_t stream, const void* data = nullptr, size_t size = 0)
+        {
+            const size_t need = kRecordHeader + size;
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (!m_Open.load(std::memory_order_relaxed))
+                return;
+
+            // 락 안에서 : 파일 순서 = 시간 순서
+            const uint64_t timeNs = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - m_Start).count());
+            if (m_Used + need > m_Map.Size() && !m_Map.Resize(m_Map.Size() + (std::max)(kGrow, need)))
+            {
+                // 디스크가 가득 찼다 등 : 여기까지만 남긴다
+                m_Open.store(false, std::memory_order_relaxed);
+                return;
+            }
+
+            char* p = m_Map.Data() + m_Used;
+            Protocol::PutU32(p, uint32_t(size));
+            p[4] = char(kind);
+            Protocol::PutU32(p + 8, stream);
+            Protocol::PutU64(p + 12, timeNs);
+            if (size > 0)
+                std::memcpy(p + kRecordHeader, data, size);
+            m_Used += need;
+        }
+
+        void Close()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Used == 0)
+                return;
+            m_Open.store(false, std::memory_order_relaxed);
+            m_Map.Close(m_Used);
+            m_Used = 0;
+        }
+
+        size_t Bytes()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Used;
+        }
+
+    private:
+        std::mutex m_Mutex;
+        Mapping m_Map;
+        size_t m_Used = 0; // 0 = 닫혀 있다
+        std::chrono::steady_clock::time_point m_Start;
+        std::atomic<bool> m_Open{ false };
+    };
+
+    // -------------------------
+    // Reader : 처음부터 순서대로
+    // -------------------------
+    class Reader
+    {
+    public:
+        bool Open(const std::filesystem::path& path)
+        {
+            if (!m_Map.OpenRead(path) || m_Map.Size() < kFileHeader ||
+                std::memcmp(m_Map.Data(), kMagic, sizeof(kMagic)) != 0 ||
+                Protocol::GetU32(m_Map.Data() + 8) != kVersion)
+            {
+                m_Map.Close();
+                return false;
+            }
+            m_Pos = kFileHeader;
+            return true;
+        }
+
+        // false : 끝 (또는 잘린 레코드)
+        bool Next(Record& r)
+        {
+            const char* base = m_Map.Data();
+            if (!base || m_Pos + kRecordHeader > m_Map.Size())
+                return false;
+
+            const char* p = base + m_Pos;
+            r.size = Protocol::GetU32(p);
+            r.kind = Kind(uint8_t(p[4]));
+            r.stream = Protocol::GetU32(p + 8);
+            r.timeNs = Protocol::GetU64(p + 12);
+            r.data = p + kRecordHeader;
+            if (r.kind == Kind::End || r.kind > Kind::Close ||
+                m_Pos + kRecordHeader + r.size > m_Map.Size())
+                return false;
+
+            m_Pos += kRecordHeader + r.size;
+            return true;
+        }
+
+        void Rewind() { m_Pos = kFileHeader; }
+
+    private:
+        Mapping m_Map;
+        size_t m_Pos = 0;
+    };
+}
@@ -0,0 +1,654 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// =====================================================
+// Wire protocol (shared by Server and D3DBoxApp)
+//
+// v1 : text lines  "MOVE <key> <x> <z>\n"
+// v2 : binary frames [u16 len][u8 op][payload], little endian
+//      len = sizeof(op) + payload size
+//
+// The server always greets with the text line "ASSIGN <key> <maxVersion>\n".
+// A v2 client answers "HELLO <version>\n"; after that both directions
+// switch to binary frames. A client that never says HELLO stays on v1.
+//
+// Obstacles are server state too : OBSTACLE_SET / OBSTACLE_CLEAR <x> <z> go
+// client -> server and are echoed to everyone. The join snapshot carries the
+// whole layer as OBSTACLE_RUN <len> <x> <z> (v1) or OBSTACLE_ROWS chunks (v2).
+//
+// Client MOVE carries a sequence number in the key slot ("MOVE <x> <z> [seq]" in
+// text). The server answers the mover alone with MOVE_ACK <seq> <x> <z> : the
+// authoritative cell after that request (unchanged if it was rejected).
+//
+// Each tick's MOVE batch to a session is preceded by TICK <n> <rateHz>, so
+// clients can time-stamp server states (interpolation buffer).
+//
+// Optional UDP channel (server --udp-port, v2 sessions only) : the greeting
+// becomes "ASSIGN <key> <udpPort> <udpToken> <maxVersion>\n" (old clients
+// only read the first and last field). MOVE, MOVE_ACK and the TICK + MOVE
+// batch may then travel as datagrams, unreliable but sequenced : a datagram
+// older than the last one received is dropped, because every MOVE
+// supersedes the previous one anyway. Everything else stays on TCP.
+//
+// v3 : v2 + session resume. The join snapshot ends with TICK <n> before
+// SNAPSHOT_END, and RESUME_TOKEN <token> arrives once per join. The tick
+// number is the world version : a client that lost its connection greets
+// the new one with "RESUME <key> <token> <version>\n" instead of HELLO
+// (<version> = the last TICK it saw, 0 if it never finished a snapshot).
+// The server answers RESUME <key> :
+//   same key  : the old session is back (its block was kept for the
+//               --resume-window). Only what changed since <version>
+//               follows (SPAWN / DESPAWN / OBSTACLE_*), then TICK + SNAPSHOT_END,
+//               or a full SNAPSHOT_BEGIN .. SNAPSHOT_END when the server's
+//               history does not reach back that far.
+//   other key : a new session, as after HELLO 3; the full snapshot follows.
+// =====================================================
+namespace Protocol
+{
+    constexpr int kVersionText = 1;
+    constexpr int kVersionBinary = 2;
+    constexpr int kVersionResume = 3;
+    constexpr int kVersionLatest = kVersionResume;
+
+    enum class Op : uint8_t
+    {
+        None = 0,
+        Assign,
+        SnapshotBegin,
+        SnapshotEnd,
+        Spawn,
+        Move,
+        Despawn,
+        MoveBatch,      // v2 only, server -> client
+        ObstacleSet,
+        ObstacleClear,
+        ObstacleRun,    // server -> client, key = run length (cells, +x)
+        ObstacleRows,   // v2 only, server -> client, decodes into ObstacleRun
+        MoveAck,        // server -> client (mover only), key = seq
+        Tick,           // server -> client, key = tick number, x = tick rate (Hz)
+        Resume,         // v3, server -> client, key = sessionKey (answer to RESUME)
+        ResumeToken,    // v3, server -> client, key = token for the next RESUME
+    };
+
+    // Decoded form of one message. Fixed size, lives on the stack.
+    struct Message
+    {
+        Op      op = Op::None;
+        int32_t key = 0;   // sessionKey (server -> client), ObstacleRun : length, MOVE / MOVE_ACK : seq (mover)
+        int16_t x = 0;     // cellX
+        int16_t z = 0;     // cellZ
+    };
+
+    constexpr size_t kHeaderSize = sizeof(uint16_t) + sizeof(uint8_t);
+    constexpr size_t kMaxFrameSize = 64;
+    constexpr size_t kMaxTextLine = 64;
+
+    // -------------------------
+    // little endian helpers
+    // -------------------------
+    inline char* PutU16(char* p, uint16_t v)
+    {
+        p[0] = char(v & 0xFF);
+        p[1] = char(v >> 8);
+        return p + 2;
+    }
+
+    inline char* PutI32(char* p, int32_t v)
+    {
+        uint32_t u = uint32_t(v);
+        p[0] = char(u & 0xFF);
+        p[1] = char((u >> 8) & 0xFF);
+        p[2] = char((u >> 16) & 0xFF);
+        p[3] = char(u >> 24);
+        return p + 4;
+    }
+
+    inline char* PutU32(char* p, uint32_t v)
+    {
+        return PutI32(p, int32_t(v));
+    }
+
+    inline char* PutU64(char* p, uint64_t v)
+    {
+        p = PutU32(p, uint32_t(v));
+        return PutU32(p, uint32_t(v >> 32));
+    }
+
+    inline uint16_t GetU16(const char* p)
+    {
+        return uint16_t(uint8_t(p[0]) | (uint8_t(p[1]) << 8));
+    }
+
+    inline int32_t GetI32(const char* p)
+    {
+        return int32_t(uint32_t(uint8_t(p[0])) | (uint32_t(uint8_t(p[1])) << 8) |
+            (uint32_t(uint8_t(p[2])) << 16) | (uint32_t(uint8_t(p[3])) << 24));
+    }
+
+    inline uint32_t GetU32(const char* p)
+    {
+        return uint32_t(GetI32(p));
+    }
+
+    inline uint64_t GetU64(const char* p)
+    {
+        return uint64_t(GetU32(p)) | (uint64_t(GetU32(p + 4)) << 32);
+    }
+
+    inline size_t PayloadSize(Op op)
+    {
+        switch (op)
+        {
+        case Op::Assign:        return 4;
+        case Op::SnapshotBegin: return 0;
+        case Op::SnapshotEnd:   return 0;
+        case Op::Spawn:         return 8;
+        case Op::Move:          return 8;
+        case Op::Despawn:       return 4;
+        case Op::ObstacleSet:   return 4;
+        case Op::ObstacleClear: return 4;
+        case Op::ObstacleRun:   return 8;
+        case Op::MoveAck:       return 8;
+        case Op::Tick:          return 8;
+        case Op::Resume:        return 4;
+        case Op::ResumeToken:   return 4;
+        default:                return size_t(-1);
+        }
+    }
+
+    // -------------------------
+    // Binary (v2)
+    // -------------------------
+
+    // Writes one frame into out (at least kMaxFrameSize bytes). Returns frame size.
+    // Fixed-size ops only : MOVE_BATCH / OBSTACLE_ROWS는 EncodeMoveBatch / EncodeObstacleRows로.
+    // 그 외 op는 아무것도 쓰지 않고 0 (길이 필드가 깨진 프레임을 내보내지 않는다)
+    inline size_t EncodeBinary(const Message& m, char* out)
+    {
+        const size_t payload = PayloadSize(m.op);
+        assert(payload != size_t(-1) && "variable-size op: use EncodeMoveBatch / EncodeObstacleRows");
+        if (payload == size_t(-1))
+            return 0;
+
+        char* p = PutU16(out, uint16_t(1 + payload));
+        *p++ = char(m.op);
+
+        switch (m.op)
+        {
+        case Op::Spawn:
+        case Op::Move:
+        case Op::ObstacleRun:
+        case Op::MoveAck:
+        case Op::Tick:
+            p = PutI32(p, m.key);
+            p = PutU16(p, uint16_t(m.x));
+            p = PutU16(p, uint16_t(m.z));
+            break;
+        case Op::ObstacleSet:
+        case Op::ObstacleClear:
+            p = PutU16(p, uint16_t(m.x));
+            p = PutU16(p, uint16_t(m.z));
+            break;
+        case Op::Assign:
+        case Op::Despawn:
+        case Op::Resume:
+        case Op::ResumeToken:
+            p = PutI32(p, m.key);
+            break;
+        default:
+            break;
+        }
+        return size_t(p - out);
+    }
+
+    // Returns bytes consumed, 0 if the frame is not complete yet, -1 if malformed.
+    inline int DecodeBinary(const char* data, size_t len, Message& out)
+    {
+        if (len < kHeaderSize)
+            return 0;
+
+        const size_t body = GetU16(data);
+        if (body == 0 || body + sizeof(uint16_t) > kMaxFrameSize)
+            return -1;
+        if (len < body + sizeof(uint16_t))
+            return 0;
+
+        const Op op = Op(uint8_t(data[2]));
+        if (PayloadSize(op) != body - 1)
+            return -1;
+
+        const char* p = data + kHeaderSize;
+        out = Message{};
+        out.op = op;
+
+        switch (op)
+        {
+        case Op::Spawn:
+        case Op::Move:
+        case Op::ObstacleRun:
+        case Op::MoveAck:
+        case Op::Tick:
+            out.key = GetI32(p);
+            out.x = int16_t(GetU16(p + 4));
+            out.z = int16_t(GetU16(p + 6));
+            break;
+        case Op::ObstacleSet:
+        case Op::ObstacleClear:
+            out.x = int16_t(GetU16(p));
+            out.z = int16_t(GetU16(p + 2));
+            break;
+        case Op::Assign:
+        case Op::Despawn:
+        case Op::Resume:
+        case Op::ResumeToken:
+            out.key = GetI32(p);
+            break;
+        default:
+            break;
+        }
+        return int(body + sizeof(uint16_t));
+    }
+
+    // -------------------------
+    // MOVE batch (v2)
+    // payload : u16 count, then per entry (sorted by key)
+    //           varint(key - prevKey), zigzag varint(x), zigzag varint(z)
+    // 틱 동안 바뀐 블록만 담고, 키는 차이값이라 엔트리당 보통 3~4 바이트
+    // -------------------------
+    constexpr size_t kMaxBatchPayload = 4096;
+    constexpr size_t kMaxBatchEntry = 5 + 3 + 3;
+
+    // Upper bound on messages one frame can expand into (MOVE batch entries
+    // take >= 3 bytes, obstacle runs >= 2 bytes with the free run before them).
+    constexpr size_t kMaxFrameMessages = kMaxBatchPayload / 2 + 1;
+
+    inline char* PutVarint(char* p, uint32_t v)
+    {
+        while (v >= 0x80)
+        {
+            *p++ = char(v | 0x80);
+            v >>= 7;
+        }
+        *p++ = char(v);
+        return p;
+    }
+
+    // Returns nullptr if the varint runs past end.
+    inline const char* GetVarint(const char* p, const char* end, uint32_t& v)
+    {
+        v = 0;
+        for (int shift = 0; shift < 35 && p < end; shift += 7)
+        {
+            const uint8_t b = uint8_t(*p++);
+            v |= uint32_t(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return p;
+        }
+        return nullptr;
+    }
+
+    inline uint32_t ZigZag(int32_t v) { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+    inline int32_t UnZigZag(uint32_t v) { return int32_t(v >> 1) ^ -int32_t(v & 1); }
+
+    // Appends MOVE batch frames to out. moves must be sorted by key.
+    // Splits into several frames when the payload would pass kMaxBatchPayload.
+    inline void EncodeMoveBatch(const Message* moves, size_t count, std::string& out)
+    {
+        size_t i = 0;
+        while (i < count)
+        {
+            const size_t frameStart = out.size();
+            out.resize(frameStart + kHeaderSize + kMaxBatchPayload);
+
+            char* base = out.data() + frameStart;
+            char* p = base + kHeaderSize + sizeof(uint16_t);
+            char* limit = base + kHeaderSize + kMaxBatchPayload;
+
+            uint16_t n = 0;
+            uint32_t prevKey = 0;
+            while (i < count && p + kMaxBatchEntry <= limit)
+            {
+                p = PutVarint(p, uint32_t(moves[i].key) - prevKey);
+                p = PutVarint(p, ZigZag(moves[i].x));
+                p = PutVarint(p, ZigZag(moves[i].z));
+                prevKey = uint32_t(moves[i].key);
+                ++n;
+                ++i;
+            }
+
+            const size_t frameSize = size_t(p - base);
+            PutU16(base, uint16_t(frameSize - sizeof(uint16_t)));
+            base[2] = char(Op::MoveBatch);
+            PutU16(base + kHeaderSize, n);
+            out.resize(frameStart + frameSize);
+        }
+    }
+
+    // -------------------------
+    // Obstacle rows (v2)
+    // map    : (half * 2 + 1)^2 cells, x and z in [-half, half]
+    // payload : i16 half, u16 firstRow, u16 rowCount, then per row
+    //           varint runs alternating empty / blocked (empty first, may be 0),
+    //           summing to the row width
+    // 행 단위로만 잘라서 chunk 하나가 kMaxBatchPayload를 넘지 않는다
+    // -------------------------
+    constexpr int kMaxObstacleHalf = 1024; // 최악의 한 행(교대 패턴)도 chunk 하나에 들어간다
+    constexpr size_t kObstacleRowsHeader = 6;
+
+    // Appends one OBSTACLE_ROWS frame holding as many rows from firstRow as fit.
+    // blocked(x, z) -> bool. Returns the next row to encode (half * 2 + 1 when done).
+    template <typename F>
+    int EncodeObstacleRows(int half, int firstRow, F&& blocked, std::string& out)
+    {
+        const int width = half * 2 + 1;
+        char row[kMaxBatchPayload];
+
+        const size_t frameStart = out.size();
+        out.resize(frameStart + kHeaderSize + kObstacleRowsHeader);
+
+        int z = firstRow;
+        size_t payload = kObstacleRowsHeader;
+        for (; z < width; ++z)
+        {
+            // 한 행을 run으로
+            char* p = row;
+            bool state = false;
+            int run = 0;
+            for (int x = 0; x < width; ++x)
+            {
+                const bool b = blocked(x - half, z - half);
+                if (b != state)
+                {
+                    p = PutVarint(p, uint32_t(run));
+                    state = b;
+                    run = 0;
+                }
+                ++run;
+            }
+            p = PutVarint(p, uint32_t(run));
+
+            const size_t rowSize = size_t(p - row);
+            if (z > firstRow && payload + rowSize > kMaxBatchPayload)
+                break;
+
+            out.append(row, rowSize);
+            payload += rowSize;
+        }
+
+        char* base = out.data() + frameStart;
+        PutU16(base, uint16_t(1 + payload));
+        base[2] = char(Op::ObstacleRows);
+        PutU16(base + kHeaderSize, uint16_t(half));
+        PutU16(base + kHeaderSize + 2, uint16_t(firstRow));
+        PutU16(base + kHeaderSize + 4, uint16_t(z - firstRow));
+        return z;
+    }
+
+    // Calls onMessage(Op::ObstacleRun) for each blocked run. Returns false if malformed.
+    template <typename F>
+    bool DecodeObstacleRows(const char* p, const char* end, F&& onMessage)
+    {
+        if (end - p < ptrdiff_t(kObstacleRowsHeader))
+            return false;
+
+        const int half = int16_t(GetU16(p));
+        const int firstRow = GetU16(p + 2);
+        const int rowCount = GetU16(p + 4);
+        p += kObstacleRowsHeader;
+
+        const int width = half * 2 + 1;
+        if (half < 0 || half > kMaxObstacleHalf || firstRow + rowCount > width)
+            return false;
+
+        for (int z = firstRow; z < firstRow + rowCount; ++z)
+        {
+            int x = 0;
+            bool state = false;
+            while (x < width)
+            {
+                uint32_t run;
+                if (!(p = GetVarint(p, end, run)) || run > uint32_t(width - x))
+                    return false;
+
+                if (state && run > 0)
+                    onMessage(Message{ Op::ObstacleRun, int32_t(run), int16_t(x - half), int16_t(z - half) });
+                x += int(run);
+                state = !state;
+            }
+        }
+        return p == end;
+    }
+
+    // Decodes one frame and calls onMessage(const Message&) for each message in it.
+    // A MOVE batch expands into one Op::Move per entry, OBSTACLE_ROWS into Op::ObstacleRun.
+    // Returns bytes consumed, 0 if the frame is not complete yet, -1 if malformed.
+    template <typename F>
+    int DecodeFrame(const char* data, size_t len, F&& onMessage)
+    {
+        if (len < kHeaderSize)
+            return 0;
+
+        const Op op = Op(uint8_t(data[2]));
+        if (op != Op::MoveBatch && op != Op::ObstacleRows)
+        {
+            Message m;
+            const int used = DecodeBinary(data, len, m);
+            if (used > 0)
+                onMessage(m);
+            return used;
+        }
+
+        const size_t body = GetU16(data);
+        if (body < 1 + sizeof(uint16_t) || body - 1 > kMaxBatchPayload)
+            return -1;
+        if (len < body + sizeof(uint16_t))
+            return 0;
+
+        const char* p = data + kHeaderSize;
+        const char* end = data + sizeof(uint16_t) + body;
+
+        if (op == Op::ObstacleRows)
+            return DecodeObstacleRows(p, end, onMessage) ? int(body + sizeof(uint16_t)) : -1;
+
+        const uint16_t n = GetU16(p);
+        p += sizeof(uint16_t);
+
+        uint32_t key = 0;
+        for (uint16_t i = 0; i < n; ++i)
+        {
+            uint32_t dk, zx, zz;
+            if (!(p = GetVarint(p, end, dk)) ||
+                !(p = GetVarint(p, end, zx)) ||
+                !(p = GetVarint(p, end, zz)))
+                return -1;
+
+            key += dk;
+            onMessage(Message{ Op::Move, int32_t(key), int16_t(UnZigZag(zx)), int16_t(UnZigZag(zz)) });
+        }
+        return (p == end) ? int(body + sizeof(uint16_t)) : -1;
+    }
+
+    // -------------------------
+    // UDP datagrams (v2 frames after a small header)
+    // client -> server : u64 token, u32 seq, u8 flags, then MOVE frames
+    //                    (no frames = probe / keepalive)
+    // server -> client : u32 seq, then frames (TICK + MOVE batch, MOVE_ACK)
+    //                    (no frames = answer to a probe)
+    // seq는 방향마다 따로 센다. 받는 쪽은 마지막으로 받은 것보다 새 것만 쓴다
+    // -------------------------
+    constexpr size_t kUdpClientHeader = 8 + 4 + 1;
+    constexpr size_t kUdpServerHeader = 4;
+    constexpr size_t kMaxDatagram = 1200; // IP 조각화가 안 되는 크기
+
+    // 클라이언트가 서버 datagram을 받고 있다 -> 서버도 이 세션에 UDP로 보낸다
+    constexpr uint8_t kUdpFlagReceiving = 1;
+
+    // TICK frame + MOVE batch header가 들어가고 남는 자리 (엔트리 최대 크기 기준)
+    constexpr size_t kUdpMovesPerDatagram =
+        (kMaxDatagram - kUdpServerHeader - (kHeaderSize + 8) - (kHeaderSize + sizeof(uint16_t))) / kMaxBatchEntry;
+
+    // a가 b보다 새 seq인가 (한 바퀴 돌아도 맞다)
+    inline bool SeqNewer(uint32_t a, uint32_t b) { return int32_t(a - b) > 0; }
+
+    // Calls onMessage for every message in the frames after the header.
+    // Returns false if a frame is malformed or cut off.
+    template <typename F>
+    bool DecodeDatagram(const char* frames, size_t len, F&& onMessage)
+    {
+        while (len > 0)
+        {
+            const int used = DecodeFrame(frames, len, onMessage);
+            if (used <= 0)
+                return false;
+            frames += used;
+            len -= size_t(used);
+        }
+        return true;
+    }
+
+    // -------------------------
+    // Text (v1)
+    // -------------------------
+    inline const char* OpName(Op op)
+    {
+        switch (op)
+        {
+        case Op::Assign:        return "ASSIGN";
+        case Op::SnapshotBegin: return "SNAPSHOT_BEGIN";
+        case Op::SnapshotEnd:   return "SNAPSHOT_END";
+        case Op::Spawn:         return "SPAWN";
+        case Op::Move:          return "MOVE";
+        case Op::Despawn:       return "DESPAWN";
+        case Op::ObstacleSet:   return "OBSTACLE_SET";
+        case Op::ObstacleClear: return "OBSTACLE_CLEAR";
+        case Op::ObstacleRun:   return "OBSTACLE_RUN";
+        case Op::MoveAck:       return "MOVE_ACK";
+        case Op::Tick:          return "TICK";
+        case Op::Resume:        return "RESUME";
+        case Op::ResumeToken:   return "RESUME_TOKEN";
+        default:                return "";
+        }
+    }
+
+    // Writes one '\n' terminated line into out (at least kMaxTextLine bytes).
+    // withKey : server -> client lines carry the sessionKey, client -> server lines don't.
+    inline size_t EncodeText(const Message& m, char* out, bool withKey)
+    {
+        char* p = out;
+        char* end = out + kMaxTextLine - 1;
+
+        const char* name = OpName(m.op);
+        const size_t n = std::strlen(name);
+        std::memcpy(p, name, n);
+        p += n;
+
+        auto putInt = [&](int v)
+            {
+                *p++ = ' ';
+                p = std::to_chars(p, end, v).ptr;
+            };
+
+        switch (m.op)
+        {
+        case Op::Spawn:
+        case Op::Move:
+        case Op::ObstacleRun:
+        case Op::MoveAck:
+            if (withKey) putInt(m.key);
+            putInt(m.x);
+            putInt(m.z);
+            if (!withKey && m.op == Op::Move && m.key != 0) putInt(m.key); // client seq
+            break;
+        case Op::ObstacleSet:
+        case Op::ObstacleClear:
+            putInt(m.x);
+            putInt(m.z);
+            break;
+        case Op::Tick:
+            putInt(m.key);
+            putInt(m.x);
+            break;
+        case Op::Assign:
+        case Op::Despawn:
+            if (withKey) putInt(m.key);
+            else *p++ = ' ';
+            break;
+        default:
+            break;
+        }
+
+        *p++ = '\n';
+        return size_t(p - out);
+    }
+
+    // Parses one line (without '\n'). Returns false for unknown commands.
+    inline bool DecodeText(std::string_view line, Message& out, bool withKey)
+    {
+        out = Message{};
+
+        const size_t sp = line.find(' ');
+        const std::string_view cmd = line.substr(0, sp);
+        std::string_view rest = (sp == std::string_view::npos) ? std::string_view{} : line.substr(sp + 1);
+
+        auto nextInt = [&](auto& v)
+            {
+                while (!rest.empty() && rest.front() == ' ')
+                    rest.remove_prefix(1);
+                int tmp = 0;
+                auto [ptr, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), tmp);
+                if (ec != std::errc())
+                    return false;
+                rest.remove_prefix(size_t(ptr - rest.data()));
+                v = std::remove_reference_t<decltype(v)>(tmp);
+                return true;
+            };
+
+        if (cmd == "SPAWN" || cmd == "MOVE" || cmd == "OBSTACLE_RUN" || cmd == "MOVE_ACK")
+        {
+            out.op = (cmd == "SPAWN") ? Op::Spawn : (cmd == "MOVE") ? Op::Move
+                : (cmd == "MOVE_ACK") ? Op::MoveAck : Op::ObstacleRun;
+            if (withKey && !nextInt(out.key)) return false;
+            if (!nextInt(out.x) || !nextInt(out.z)) return false;
+            if (!withKey && out.op == Op::Move) nextInt(out.key); // optional client seq
+            return true;
+        }
+        if (cmd == "OBSTACLE_SET" || cmd == "OBSTACLE_CLEAR")
+        {
+            out.op = (cmd == "OBSTACLE_SET") ? Op::ObstacleSet : Op::ObstacleClear;
+            return nextInt(out.x) && nextInt(out.z);
+        }
+        if (cmd == "TICK")
+        {
+            out.op = Op::Tick;
+            return nextInt(out.key) && nextInt(out.x);
+        }
+        if (cmd == "DESPAWN")
+        {
+            out.op = Op::Despawn;
+            return !withKey || nextInt(out.key); // 서버 -> 클라이언트는 key가 꼭 있다
+        }
+        if (cmd == "ASSIGN")
+        {
+            out.op = Op::Assign;
+            return nextInt(out.key);
+        }
+        if (cmd == "SNAPSHOT_BEGIN")
+        {
+            out.op = Op::SnapshotBegin;
+            return true;
+        }
+        if (cmd == "SNAPSHOT_END")
+        {
+            out.op = Op::SnapshotEnd;
+            return true;
+        }
+        return false;
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+// =====================================================
+// RecvBuffer (shared by Server and D3DBoxApp)
+//
+// Socket reads land directly in the free tail, and complete frames are
+// handed out as string_views into the buffer: no per-line substr/erase.
+// Consumed bytes are reclaimed by moving the read offset; the unread
+// remainder is memmoved to the front only when the tail runs out of room.
+// =====================================================
+class RecvBuffer
+{
+public:
+    explicit RecvBuffer(std::size_t capacity = 4096, std::size_t maxCapacity = 128 * 1024)
+        : m_Data(new char[capacity])
+        , m_Capacity(capacity)
+        , m_MaxCapacity(maxCapacity)
+    {
+    }
+
+    // Takes capacity bytes of storage allocated elsewhere (new char[]); the
+    // server hands sessions their first block from a pool.
+    RecvBuffer(std::unique_ptr<char[]> storage, std::size_t capacity, std::size_t maxCapacity = 128 * 1024)
+        : m_Data(std::move(storage))
+        , m_Capacity(capacity)
+        , m_MaxCapacity(maxCapacity)
+    {
+    }
+
+    // Gives the storage back if it is still capacity bytes (a grown buffer
+    // is freed instead). The buffer is unusable afterwards.
+    std::unique_ptr<char[]> ReleaseStorage(std::size_t capacity)
+    {
+        if (m_Capacity != capacity)
+            return nullptr;
+        m_Capacity = m_Begin = m_End = 0;
+        return std::move(m_Data);
+    }
+
+    // Makes at least minSpace bytes writable (compacting, then growing up
+    // to maxCapacity). Returns the writable span; size 0 means the peer
+    // sent more unparsed data than maxCapacity allows.
+    char* Prepare(std::size_t minSpace = 512)
+    {
+        if (m_Capacity - m_End < minSpace && m_Begin > 0)
+            Compact();
+
+        if (m_Capacity - m_End < minSpace && m_Capacity < m_MaxCapacity)
+        {
+            std::size_t capacity = m_Capacity * 2;
+            while (capacity - m_End < minSpace && capacity < m_MaxCapacity)
+                capacity *= 2;
+            if (capacity > m_MaxCapacity)
+                capacity = m_MaxCapacity;
+
+            std::unique_ptr<char[]> data(new char[capacity]);
+            std::memcpy(data.get(), m_Data.get(), m_End);
+            m_Data = std::move(data);
+            m_Capacity = capacity;
+        }
+        return m_Data.get() + m_End;
+    }
+
+    std::size_t Space() const { return m_Capacity - m_End; }
+
+    // Drops whatever is unread (the client starts over on a new connection).
+    void Clear() { m_Begin = m_End = 0; }
+
+    // Marks n bytes written by the last read as readable.
+    void Commit(std::size_t n) { m_End += n; }
+
+    std::string_view Data() const { return std::string_view(m_Data.get() + m_Begin, m_End - m_Begin); }
+
+    void Consume(std::size_t n)
+    {
+        m_Begin += n;
+        if (m_Begin == m_End)
+            m_Begin = m_End = 0; // drained: no memmove needed
+    }
+
+    // Next '\n' terminated line without the '\n'. The view is valid until
+    // the next Prepare.
+    bool NextLine(std::string_view& line)
+    {
+        const char* begin = m_Data.get() + m_Begin;
+        const char* nl = static_cast<const char*>(std::memchr(begin, '\n', m_End - m_Begin));
+        if (!nl)
+            return false;
+
+        line = std::string_view(begin, std::size_t(nl - begin));
+        Consume(line.size() + 1);
+        return true;
+    }
+
+private:
+    void Compact()
+    {
+        const std::size_t size = m_End - m_Begin;
+        std::memmove(m_Data.get(), m_Data.get() + m_Begin, size);
+        m_Begin = 0;
+        m_End = size;
+    }
+
+private:
+    std::unique_ptr<char[]> m_Data;
+    std::size_t m_Capacity;
+    std::size_t m_MaxCapacity;
+    std::size_t m_Begin = 0;
+    std::size_t m_End = 0;
+};